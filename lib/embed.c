@@ -1,10 +1,12 @@
-/* rvcc C compiler - tool to refresh embedded version of rvclib from source */
+/* rvcc C compiler - tool to refresh embedded version of rvclib from source, and its precompiled objects */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#define MAX_LINE_LEN 200
-#define MAX_SIZE 65536
+#define MAX_LINE_LEN 256
+#define MAX_SIZE 1048576
+#define BYTES_PER_LINE 64
 
 char *_source;
 int _source_idx;
@@ -61,6 +63,45 @@ void s_load(char *file)
 	fclose(f);
 }
 
+void s_write_hex(int c)
+{
+	char *digits = "0123456789abcdef";
+
+	s_write_char(digits[(c >> 4) & 15]);
+	s_write_char(digits[c & 15]);
+}
+
+/* writes object file as function passing its bytes in hex to __o */
+void s_load_object(char *name, char *file)
+{
+	FILE *f;
+	int c, n = 0;
+
+	printf("Loading object file %s\n", file);
+
+	s_write_string("void e_clib_");
+	s_write_string(name);
+	s_write_string("() {\n");
+	f = fopen(file, "rb");
+	if (f == NULL) {
+		printf("Unable to open %s\n", file);
+		exit(1);
+	}
+	while ((c = fgetc(f)) != EOF) {
+		if (n == 0)
+			s_write_string("__o(\"");
+		s_write_hex(c);
+		if (++n == BYTES_PER_LINE) {
+			s_write_string("\");\n");
+			n = 0;
+		}
+	}
+	if (n != 0)
+		s_write_string("\");\n");
+	fclose(f);
+	s_write_string("}\n");
+}
+
 void s_save(char *file)
 {
 	FILE *f;
@@ -77,7 +118,17 @@ void s_save(char *file)
 
 int main(int argc, char *argv[])
 {
-	if (argc > 2) {
+	int i;
+
+	if (argc > 3 && strcmp(argv[1], "-objects") == 0) {
+		_source_idx = 0;
+		_source = malloc(MAX_SIZE);
+
+		s_write_string("/* startup code and clib precompiled for each architecture by make clib */\n");
+		for (i = 3; i + 1 < argc; i += 2)
+			s_load_object(argv[i], argv[i + 1]);
+		s_save(argv[2]);
+	} else if (argc > 2) {
 		_source_idx = 0;
 		_source = malloc(MAX_SIZE);
 
@@ -87,6 +138,7 @@ int main(int argc, char *argv[])
 		s_save(argv[2]);
 	} else {
 		printf("Usage: embed <input.c> <output.inc>\n");
+		printf("       embed -objects <output.inc> <arch> <input.o>...\n");
 	}
 	return 0;
 }
@@ -9,6 +9,25 @@
 #define __syscall_close 57
 #define __syscall_open 1024
 #define __syscall_brk 214
+/* renameat2, RISC-V has no renameat */
+#define __syscall_renameat 276
+#define __syscall_unlinkat 35
+#define __syscall_getpid 172
+#define __syscall_getcwd 17
+#define __syscall_chdir 49
+/* dup3, clone and sendto, RISC-V has no dup2, fork or send */
+#define __syscall_dup2 24
+#define __syscall_fork 220
+#define __syscall_wait4 260
+#define __syscall_socket 198
+#define __syscall_bind 200
+#define __syscall_listen 201
+#define __syscall_accept 202
+#define __syscall_connect 203
+#define __syscall_send 206
+#define __syscall_getdents 61
+#define __syscall_statx 291
+#define __syscall_utimensat 88
 #endif
 
 #ifdef __ARM
@@ -18,379 +37,1213 @@
 #define __syscall_close 6
 #define __syscall_open 5
 #define __syscall_brk 45
+#define __syscall_renameat 329
+#define __syscall_unlinkat 328
+#define __syscall_getpid 20
+#define __syscall_getcwd 183
+#define __syscall_chdir 12
+#define __syscall_dup2 63
+#define __syscall_fork 2
+#define __syscall_wait4 114
+#define __syscall_socket 281
+#define __syscall_bind 282
+#define __syscall_listen 284
+#define __syscall_accept 285
+#define __syscall_connect 283
+#define __syscall_send 289
+#define __syscall_getdents 217
+#define __syscall_statx 397
+#define __syscall_utimensat 348
 #endif
 
-typedef int FILE;
+#define AF_UNIX 1
+#define SOCK_STREAM 1
+#define MSG_NOSIGNAL 0x4000
+
+#define __FILE_BUFSIZE 4096
+
+/* buffered stream, closed ones free their buffer and stay listed for the next fopen */
+typedef struct {
+	int fd;
+	int mode; /* 0 closed, 1 reading, 2 writing */
+	char *buf;
+	int pos; /* next byte in buffer */
+	int len; /* bytes read into buffer */
+	void *next; /* next stream ever opened */
+} FILE;
+
+FILE *__streams;
+FILE *stdout;
+
+/* directory entry, only its name */
+typedef struct {
+	char d_name[256];
+} dirent;
+
+/* directory being read, getdents64 fills buf with records of 8-byte inode and offset, 2-byte length, type and name */
+typedef struct {
+	int fd;
+	char *buf;
+	int pos; /* next record in buffer */
+	int len; /* bytes read into buffer */
+	dirent *entry;
+} DIR;
+
+/* file status, only its modification time */
+typedef struct {
+	int st_mtime;
+} stat;
 
 void abort();
+void *malloc(int size);
+void free(void *ptr);
+int fflush(FILE *stream);
+
+/* string and memory routines work a word at a time once both pointers are aligned,
+ a word w holds a zero byte if ((w - 0x01010101) & ~w & 0x80808080) != 0 */
+#define __WORD_ONES 0x01010101
+#define __WORD_HIGHS 0x80808080
 
 int strlen(char *str)
 {
-	int i = 0;
+	int *w;
+	int i = 0, a = str, k = 0, v;
 
-	while (str[i] != 0)
+	/* bytes up to word boundary */
+	while (((a + i) & 3) != 0) {
+		if (str[i] == 0)
+			return i;
 		i++;
+	}
 
+	/* words without a zero byte */
+	w = str + i;
+	v = w[0];
+	while ((((v - __WORD_ONES) & (-1 - v)) & __WORD_HIGHS) == 0) {
+		k++;
+		v = w[k];
+	}
+	i += k << 2;
+
+	while (str[i] != 0)
+		i++;
 	return i;
 }
 
-int strcmp(char *s1, char *s2)
+/* length of str, at most max */
+int __strnlen(char *str, int max)
 {
-	int i = 0;
+	int *w;
+	int i = 0, a = str, k = 0, n, v;
 
-	while (s1[i] != 0 && s2[i] != 0) {
-		if (s1[i] < s2[i])
-			return -1;
-		else if (s1[i] > s2[i])
-			return 1;
+	while ((((a + i) & 3) != 0) && (i < max)) {
+		if (str[i] == 0)
+			return i;
 		i++;
 	}
-	return s2[i] - s1[i];
+
+	w = str + i;
+	n = (max - i) >> 2;
+	while (k < n) {
+		v = w[k];
+		if ((((v - __WORD_ONES) & (-1 - v)) & __WORD_HIGHS) != 0)
+			n = k; /* stop at word holding the zero */
+		else
+			k++;
+	}
+	i += k << 2;
+
+	while (i < max) {
+		if (str[i] == 0)
+			return i;
+		i++;
+	}
+	return i;
+}
+
+/* strcmp past an equal first byte */
+int __strcmp(char *s1, char *s2)
+{
+	int *w1;
+	int *w2;
+	int i = 0, a = s1, b = s2, k = 0, v;
+
+	if (((a - b) & 3) == 0) {
+		/* bytes up to word boundary */
+		while (((a + i) & 3) != 0) {
+			if ((s1[i] != s2[i]) || (s1[i] == 0))
+				return (s1[i] & 255) - (s2[i] & 255);
+			i++;
+		}
+
+		/* equal words without a zero byte */
+		w1 = s1 + i;
+		w2 = s2 + i;
+		v = w1[0];
+		while ((v == w2[k]) && ((((v - __WORD_ONES) & (-1 - v)) & __WORD_HIGHS) == 0)) {
+			k++;
+			v = w1[k];
+		}
+		i += k << 2;
+	}
+
+	while ((s1[i] == s2[i]) && (s1[i] != 0))
+		i++;
+	return (s1[i] & 255) - (s2[i] & 255);
+}
+
+int strcmp(char *s1, char *s2)
+{
+	/* lookups mostly differ in the first byte, keep that path short */
+	if (s1[0] != s2[0])
+		return (s1[0] & 255) - (s2[0] & 255);
+	return __strcmp(s1, s2);
 }
 
 int strncmp(char *s1, char *s2, int len)
 {
-	int i = 0;
+	int *w1;
+	int *w2;
+	int i = 0, a = s1, b = s2, k = 0, n, v;
+
+	if (((a - b) & 3) == 0) {
+		while ((((a + i) & 3) != 0) && (i < len)) {
+			if ((s1[i] != s2[i]) || (s1[i] == 0))
+				return (s1[i] & 255) - (s2[i] & 255);
+			i++;
+		}
+
+		w1 = s1 + i;
+		w2 = s2 + i;
+		n = (len - i) >> 2;
+		while (k < n) {
+			v = w1[k];
+			if ((v != w2[k]) || ((((v - __WORD_ONES) & (-1 - v)) & __WORD_HIGHS) != 0))
+				n = k; /* bytes decide from here */
+			else
+				k++;
+		}
+		i += k << 2;
+	}
+
 	while (i < len) {
-		if (s1[i] < s2[i])
-			return -1;
-		else if (s1[i] > s2[i])
-			return 1;
+		if ((s1[i] != s2[i]) || (s1[i] == 0))
+			return (s1[i] & 255) - (s2[i] & 255);
 		i++;
 	}
 	return 0;
 }
 
-char *strcpy(char *dest, char *src)
+char *memcpy(char *dest, char *src, int count)
 {
-	int i = 0;
-	while (src[i] != 0) {
+	int *d;
+	int *s;
+	int i = 0, a = dest, b = src, k = 0, n;
+
+	if (((a - b) & 3) == 0) {
+		while ((((a + i) & 3) != 0) && (i < count)) {
+			dest[i] = src[i];
+			i++;
+		}
+
+		/* words, four at a time */
+		d = dest + i;
+		s = src + i;
+		n = (count - i) >> 2;
+		while ((k + 4) <= n) {
+			d[k] = s[k];
+			d[k + 1] = s[k + 1];
+			d[k + 2] = s[k + 2];
+			d[k + 3] = s[k + 3];
+			k += 4;
+		}
+		while (k < n) {
+			d[k] = s[k];
+			k++;
+		}
+		i += n << 2;
+	}
+
+	while (i < count) {
 		dest[i] = src[i];
 		i++;
 	}
-	dest[i] = 0;
 	return dest;
 }
 
-char *strncpy(char *dest, char *src, int len)
+/* like memcpy, but areas may overlap */
+char *memmove(char *dest, char *src, int count)
 {
-	int i = 0;
-	int beyond = 0;
+	int *d;
+	int *s;
+	int i = count, a = dest, b = src, j, k;
 
-	while (i < len) {
-		if (beyond == 0) {
+	if ((a <= b) || (a >= (b + count)))
+		return memcpy(dest, src, count);
+
+	/* dest is above src, copy from the end */
+	if (((a - b) & 3) == 0) {
+		while ((((a + i) & 3) != 0) && (i > 0)) {
+			i--;
 			dest[i] = src[i];
-			if (src[i] == 0) {
-				beyond = 1;
-			}
-		} else {
-			dest[i] = 0;
 		}
-		i++;
+
+		/* words down to the first aligned one, bytes before it go last */
+		j = (4 - (a & 3)) & 3;
+		if (j > i)
+			j = i;
+		d = dest + j;
+		s = src + j;
+		k = (i - j) >> 2;
+		while (k > 0) {
+			k--;
+			d[k] = s[k];
+		}
+		i = j;
+	}
+
+	while (i > 0) {
+		i--;
+		dest[i] = src[i];
 	}
 	return dest;
 }
 
-/* set 10 digits (32bit) without div */
-void __render10(char *pb, int val)
+char *memset(char *dest, int c, int count)
 {
-	int neg = 0;
+	int *d;
+	int i = 0, a = dest, k = 0, n, v;
 
-	if (val < 0) {
-		neg = 1;
-		val = -val;
+	c = c & 255;
+	while ((((a + i) & 3) != 0) && (i < count)) {
+		dest[i] = c;
+		i++;
 	}
 
-	while (val >= 1000000000) {
-		val -= 1000000000;
-		pb[0]++;
+	/* words, four at a time */
+	v = c | (c << 8);
+	v = v | (v << 16);
+	d = dest + i;
+	n = (count - i) >> 2;
+	while ((k + 4) <= n) {
+		d[k] = v;
+		d[k + 1] = v;
+		d[k + 2] = v;
+		d[k + 3] = v;
+		k += 4;
 	}
-	while (val >= 100000000) {
-		val -= 100000000;
-		pb[1]++;
+	while (k < n) {
+		d[k] = v;
+		k++;
 	}
-	while (val >= 10000000) {
-		val -= 10000000;
-		pb[2]++;
+	i += n << 2;
+
+	while (i < count) {
+		dest[i] = c;
+		i++;
 	}
-	while (val >= 1000000) {
-		val -= 1000000;
-		pb[3]++;
+	return dest;
+}
+
+int memcmp(char *s1, char *s2, int count)
+{
+	int *w1;
+	int *w2;
+	int i = 0, a = s1, b = s2, k = 0, n;
+
+	if (((a - b) & 3) == 0) {
+		while ((((a + i) & 3) != 0) && (i < count)) {
+			if (s1[i] != s2[i])
+				return (s1[i] & 255) - (s2[i] & 255);
+			i++;
+		}
+
+		/* equal words, differing one is compared by bytes */
+		w1 = s1 + i;
+		w2 = s2 + i;
+		n = (count - i) >> 2;
+		while (k < n) {
+			if (w1[k] != w2[k])
+				n = k;
+			else
+				k++;
+		}
+		i += k << 2;
 	}
-	while (val >= 100000) {
-		val -= 100000;
-		pb[4]++;
+
+	while (i < count) {
+		if (s1[i] != s2[i])
+			return (s1[i] & 255) - (s2[i] & 255);
+		i++;
 	}
-	while (val >= 10000) {
-		val -= 10000;
-		pb[5]++;
+	return 0;
+}
+
+char *strcpy(char *dest, char *src)
+{
+	memcpy(dest, src, strlen(src) + 1);
+	return dest;
+}
+
+char *strncpy(char *dest, char *src, int len)
+{
+	int n = __strnlen(src, len);
+
+	memcpy(dest, src, n);
+	memset(dest + n, 0, len - n);
+	return dest;
+}
+
+int atoi(char *str)
+{
+	int i = 0, n = 0, sign = 1;
+
+	if (str[0] == '-') {
+		sign = -1;
+		i++;
 	}
-	while (val >= 1000) {
-		val -= 1000;
-		pb[6]++;
+	while ((str[i] >= '0') && (str[i] <= '9')) {
+		n = (n * 10) + (str[i] - '0');
+		i++;
 	}
-	while (val >= 100) {
-		val -= 100;
-		pb[7]++;
+	return n * sign;
+}
+
+void exit(int exit_code)
+{
+	fflush(NULL);
+	__syscall(__syscall_exit, exit_code);
+}
+
+/* paths are relative to the working directory, AT_FDCWD */
+int rename(char *oldname, char *newname)
+{
+	if (__syscall(__syscall_renameat, -100, oldname, -100, newname, 0) < 0)
+		return -1;
+	return 0;
+}
+
+int remove(char *filename)
+{
+	if (__syscall(__syscall_unlinkat, -100, filename, 0) < 0)
+		return -1;
+	return 0;
+}
+
+int getpid()
+{
+	return __syscall(__syscall_getpid);
+}
+
+int read(int fd, char *buf, int count)
+{
+	return __syscall(__syscall_read, fd, buf, count);
+}
+
+int write(int fd, char *buf, int count)
+{
+	return __syscall(__syscall_write, fd, buf, count);
+}
+
+int close(int fd)
+{
+	return __syscall(__syscall_close, fd);
+}
+
+char *getcwd(char *buf, int size)
+{
+	if (__syscall(__syscall_getcwd, buf, size) < 0)
+		return NULL;
+	return buf;
+}
+
+int chdir(char *path)
+{
+	return __syscall(__syscall_chdir, path);
+}
+
+int dup2(int oldfd, int newfd)
+{
+	return __syscall(__syscall_dup2, oldfd, newfd, 0);
+}
+
+/* clone with SIGCHLD only where fork is missing */
+int fork()
+{
+	return __syscall(__syscall_fork, 17, 0, 0, 0, 0);
+}
+
+int waitpid(int pid, int *status, int options)
+{
+	return __syscall(__syscall_wait4, pid, status, options, 0);
+}
+
+int socket(int domain, int type, int protocol)
+{
+	return __syscall(__syscall_socket, domain, type, protocol);
+}
+
+int bind(int fd, void *addr, int len)
+{
+	return __syscall(__syscall_bind, fd, addr, len);
+}
+
+int listen(int fd, int backlog)
+{
+	return __syscall(__syscall_listen, fd, backlog);
+}
+
+int accept(int fd, void *addr, void *len)
+{
+	return __syscall(__syscall_accept, fd, addr, len);
+}
+
+int connect(int fd, void *addr, int len)
+{
+	return __syscall(__syscall_connect, fd, addr, len);
+}
+
+/* no destination address when sendto stands in for send */
+int send(int fd, char *buf, int len, int flags)
+{
+	return __syscall(__syscall_send, fd, buf, len, flags, 0);
+}
+
+DIR *opendir(char *name)
+{
+	DIR *dir;
+	int fd = __syscall(__syscall_open, name, 0, 0);
+
+	if (fd < 0)
+		return NULL;
+	dir = malloc(sizeof(DIR));
+	dir->fd = fd;
+	dir->buf = malloc(__FILE_BUFSIZE);
+	dir->pos = 0;
+	dir->len = 0;
+	dir->entry = malloc(sizeof(dirent));
+	return dir;
+}
+
+/* next entry, NULL once all were read */
+dirent *readdir(DIR *dir)
+{
+	dirent *entry = dir->entry;
+	char *rec;
+
+	if (dir->pos >= dir->len) {
+		dir->len = __syscall(__syscall_getdents, dir->fd, dir->buf, __FILE_BUFSIZE);
+		dir->pos = 0;
+		if (dir->len <= 0)
+			return NULL;
 	}
-	while (val >= 10) {
-		val -= 10;
-		pb[8]++;
+	rec = dir->buf + dir->pos;
+	dir->pos += (rec[16] & 255) + ((rec[17] & 255) << 8);
+	strcpy(entry->d_name, rec + 19);
+	return entry;
+}
+
+int closedir(DIR *dir)
+{
+	int r = __syscall(__syscall_close, dir->fd);
+
+	free(dir->buf);
+	free(dir->entry);
+	free(dir);
+	return r;
+}
+
+/* statx fills 256 bytes, seconds of modification time are at byte 112 */
+int stat(char *path, struct stat *buf)
+{
+	int stx[64];
+
+	if (__syscall(__syscall_statx, -100, path, 0, 0x40, stx) < 0)
+		return -1;
+	buf->st_mtime = stx[28];
+	return 0;
+}
+
+/* only sets both times to now, times must be NULL */
+int utime(char *path, void *times)
+{
+	if (__syscall(__syscall_utimensat, -100, path, times, 0) < 0)
+		return -1;
+	return 0;
+}
+
+/* returns a closed stream, or a new one if all are open, with a fresh buffer */
+FILE *__stream()
+{
+	FILE *stream = __streams;
+
+	while (stream != NULL) {
+		if (stream->mode == 0) {
+			stream->buf = malloc(__FILE_BUFSIZE);
+			return stream;
+		}
+		stream = stream->next;
 	}
-	while (val >= 1) {
-		val -= 1;
-		pb[9]++;
+	stream = malloc(sizeof(FILE));
+	stream->buf = malloc(__FILE_BUFSIZE);
+	stream->next = __streams;
+	__streams = stream;
+	return stream;
+}
+
+FILE *fopen(char *filename, char *mode)
+{
+	FILE *stream;
+	int fd, m;
+
+	if (strcmp(mode, "wb") == 0) {
+		fd = __syscall(__syscall_open, filename, 577, 0x1c0); /* O_WRONLY | O_CREAT | O_TRUNC */
+		m = 2;
+	} else if (strcmp(mode, "rb") == 0) {
+		fd = __syscall(__syscall_open, filename, 0, 0);
+		m = 1;
+	} else
+		abort();
+	if (fd < 0)
+		return NULL;
+
+	stream = __stream();
+	stream->fd = fd;
+	stream->mode = m;
+	stream->pos = 0;
+	stream->len = 0;
+	return stream;
+}
+
+/* writes out pending output, of every stream if NULL */
+int fflush(FILE *stream)
+{
+	char *buf;
+	int w, i = 0;
+
+	if (stream == NULL) {
+		stream = __streams;
+		while (stream != NULL) {
+			fflush(stream);
+			stream = stream->next;
+		}
+		return 0;
 	}
+	if (stream->mode != 2)
+		return 0;
 
-	if (neg == 1) {
-		int c = 0;
-		while (pb[c] == '0')
-			c++;
-		if (c > 0)
-			pb[c - 1] = '-';
+	buf = stream->buf;
+	while (i < stream->pos) {
+		w = __syscall(__syscall_write, stream->fd, buf + i, stream->pos - i);
+		if (w <= 0) {
+			stream->pos = 0;
+			return -1;
+		}
+		i += w;
 	}
+	stream->pos = 0;
+	return 0;
 }
 
-void __render16(char *pb, int val)
+/* called by __start before main */
+void __stdio_init()
 {
-	int c = 9;
-	while (c > 0) {
-		int v = val & 0xf;
-		if (v < 10)
-			pb[c] = '0' + v;
-		else if (v < 16)
-			pb[c] = 'a' + v - 10;
-		else
-			abort();
-		val = val >> 4;
-		c--;
-	}
+	stdout = __stream();
+	stdout->fd = 1;
+	stdout->mode = 2;
+	stdout->pos = 0;
 }
 
-int __format(char *buffer, int val, int width, int zeropad, int base, int hexprefix)
+/* called by __start once main returns */
+void __stdio_exit()
 {
-	int bi = 0;
-	char pb[10];
-	int pbi = 0;
+	fflush(NULL);
+}
 
-	if (hexprefix == 1) {
-		buffer[0] = '0';
-		buffer[1] = 'x';
-		bi = 2;
-		if (width > 2)
-			width -= 2;
-		else
-			width = 0;
-	}
+int fclose(FILE *stream)
+{
+	int r = fflush(stream);
+	__syscall(__syscall_close, stream->fd);
+	stream->mode = 0;
+	free(stream->buf);
+	stream->buf = NULL;
+	return r;
+}
+
+/* reads next block into buffer, returns bytes available */
+int __fill(FILE *stream)
+{
+	int r = __syscall(__syscall_read, stream->fd, stream->buf, __FILE_BUFSIZE);
+	if (r < 0)
+		r = 0;
+	stream->pos = 0;
+	stream->len = r;
+	return r;
+}
 
-	/* set to zeroes */
-	while (pbi < 10) {
-		pb[pbi] = '0';
-		pbi++;
+int fgetc(FILE *stream)
+{
+	char *buf = stream->buf;
+	int c;
+
+	if (stream->pos == stream->len)
+		if (__fill(stream) == 0)
+			return -1;
+	c = buf[stream->pos];
+	stream->pos++;
+	return c;
+}
+
+char *fgets(char *str, int n, FILE *stream)
+{
+	char *buf = stream->buf;
+	int i = 0, p, c = 0;
+
+	n--;
+	while (i < n) {
+		if (stream->pos == stream->len) {
+			if (__fill(stream) == 0) {
+				if (i == 0)
+					/* EOF on first char */
+					return NULL;
+				/* EOF in the middle */
+				str[i] = 0;
+				return str;
+			}
+		}
+
+		/* copy from buffer up to end of line */
+		p = stream->pos;
+		while ((p < stream->len) && (i < n) && (c != '\n')) {
+			c = buf[p];
+			str[i] = c;
+			p++;
+			i++;
+		}
+		stream->pos = p;
+		if (c == '\n') {
+			str[i] = 0;
+			return str;
+		}
 	}
+	str[i] = 0;
+	return str;
+}
 
-	if (base == 10)
-		__render10(pb, val);
-	else if (base == 16)
-		__render16(pb, val);
-	else
-		abort();
+int fread(char *ptr, int size, int count, FILE *stream)
+{
+	int n = size * count, i = 0, k;
 
-	while (width > 10) {
-		/* need to add extra padding */
-		if (zeropad == 1)
-			buffer[bi] = '0';
-		else
-			buffer[bi] = ' ';
-		bi++;
-		width--;
-	}
-
-	/* no padding */
-	if (width == 0) {
-		int c = 0;
-		int started = 0;
-
-		/* output from first digit */
-		while (c < 10) {
-			if (pb[c] != '0')
-				started = 1;
-			if (started) {
-				buffer[bi] = pb[c];
-				bi++;
+	while (i < n) {
+		if (stream->pos == stream->len) {
+			if ((n - i) >= __FILE_BUFSIZE) {
+				/* large reads bypass the buffer */
+				k = __syscall(__syscall_read, stream->fd, ptr + i, n - i);
+				if (k > 0)
+					i += k;
+			} else
+				k = __fill(stream);
+			if (k <= 0) {
+				/* count whole items read */
+				n = 0;
+				while (i >= size) {
+					i -= size;
+					n++;
+				}
+				return n;
 			}
-			c++;
+		} else {
+			k = stream->len - stream->pos;
+			if (k > (n - i))
+				k = n - i;
+			memcpy(ptr + i, stream->buf + stream->pos, k);
+			stream->pos += k;
+			i += k;
 		}
-		/* special case - zero */
-		if (started == 0) {
-			buffer[bi] = '0';
-			bi++;
+	}
+	return count;
+}
+
+int fputc(int c, FILE *stream)
+{
+	char *buf = stream->buf;
+
+	if (stream->pos == __FILE_BUFSIZE)
+		fflush(stream);
+	buf[stream->pos] = c;
+	stream->pos++;
+	return c;
+}
+
+int fwrite(char *ptr, int size, int count, FILE *stream)
+{
+	int n = size * count, i = 0, k;
+
+	while (i < n) {
+		if (stream->pos == __FILE_BUFSIZE)
+			fflush(stream);
+		if ((stream->pos == 0) && ((n - i) >= __FILE_BUFSIZE)) {
+			/* large writes bypass the buffer */
+			k = __syscall(__syscall_write, stream->fd, ptr + i, n - i);
+			if (k <= 0) {
+				/* count whole items written */
+				n = 0;
+				while (i >= size) {
+					i -= size;
+					n++;
+				}
+				return n;
+			}
+		} else {
+			k = __FILE_BUFSIZE - stream->pos;
+			if (k > (n - i))
+				k = n - i;
+			memcpy(stream->buf + stream->pos, ptr + i, k);
+			stream->pos += k;
 		}
-	} else {
-		/* padding */
-		int c = 10 - width;
-		int started = 0;
-		while (c < 10) {
-			if (pb[c] != '0')
-				started = 1;
-			if (started)
-				buffer[bi] = pb[c];
-			else if (zeropad == 1)
-				buffer[bi] = '0';
-			else
-				buffer[bi] = ' ';
-			bi++;
-			c++;
+		i += k;
+	}
+	return count;
+}
+
+int fputs(char *str, FILE *stream)
+{
+	int n = strlen(str);
+	fwrite(str, 1, n, stream);
+	return n;
+}
+
+/* appends n bytes to a stream, or to a string stream (mode 3) as far as it has room */
+void __fput(FILE *f, char *src, int n)
+{
+	char *dst = f->buf + f->pos;
+	int i = 0, room = n;
+
+	if (f->mode == 3) {
+		/* pos counts every byte, len is the room */
+		room = f->len - f->pos;
+		if (room > n)
+			room = n;
+	} else if ((f->pos + n) > __FILE_BUFSIZE) {
+		fwrite(src, 1, n, f);
+		return;
+	}
+	if (room > 8)
+		memcpy(dst, src, room);
+	else
+		while (i < room) {
+			dst[i] = src[i];
+			i++;
 		}
+	f->pos = f->pos + n;
+}
+
+/* writes n copies of c, which is a space or '0' */
+void __fpad(FILE *f, int c, int n)
+{
+	char *pad = "                ";
+
+	if (c == '0')
+		pad = "0000000000000000";
+	while (n > 16) {
+		__fput(f, pad, 16);
+		n -= 16;
+	}
+	if (n > 0)
+		__fput(f, pad, n);
+}
+
+/* n / 100 for any 32-bit unsigned n, by shifts since there is no divide */
+int __div100(int n)
+{
+	int q, r, i;
+
+	for (i = 0; i < 2; i++) {
+		/* n / 10 */
+		q = (n >> 1) + (n >> 2);
+		q = q + (q >> 4);
+		q = q + (q >> 8);
+		q = q + (q >> 16);
+		q = q >> 3;
+		r = n - (((q << 2) + q) << 1);
+		if (r > 9)
+			q++;
+		n = q;
 	}
-	return bi;
+	return n;
 }
 
-void printf(char *str, ...)
+/* renders unsigned n into end of pb, two digits per step, returns index of first digit */
+int __render10(char *pb, int n)
 {
-	int *var_args = &str - 4;
-	char buffer[200];
-	int si = 0, bi = 0, pi = 0;
+	char *pairs = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+	int i = 12, q, r;
 
-	while (str[si] != 0) {
-		if (str[si] != '%') {
-			buffer[bi] = str[si];
-			bi++;
+	/* n * 5243 >> 19 is n / 100 below 43699 */
+	while ((n < 0) || (n >= 43699)) {
+		q = __div100(n);
+		r = (n - (q * 100)) << 1;
+		pb[i - 1] = pairs[r + 1];
+		pb[i - 2] = pairs[r];
+		i -= 2;
+		n = q;
+	}
+	while (n >= 100) {
+		q = (n * 5243) >> 19;
+		r = (n - (q * 100)) << 1;
+		pb[i - 1] = pairs[r + 1];
+		pb[i - 2] = pairs[r];
+		i -= 2;
+		n = q;
+	}
+	if (n >= 10) {
+		r = n << 1;
+		pb[i - 1] = pairs[r + 1];
+		pb[i - 2] = pairs[r];
+		return i - 2;
+	}
+	pb[i - 1] = '0' + n;
+	return i - 1;
+}
+
+int __render16(char *pb, int n)
+{
+	char *hex = "0123456789abcdef";
+	int i = 12;
+
+	do {
+		i--;
+		pb[i] = hex[n & 15];
+		n = n >> 4;
+	} while (n != 0);
+	return i;
+}
+
+/* printf engine writing straight into stream f, args walk down from the first variadic parameter */
+int __vfprintf(FILE *f, char *fmt, int *args)
+{
+	char pb[12];
+	char *pfx;
+	char *str;
+	int si = 0, ai = 0, total = 0, run, c, w, zp, alt, left, first, n, v, plen;
+
+	while (fmt[si] != 0) {
+		/* literal text up to next conversion */
+		run = si;
+		c = fmt[si];
+		while ((c != 0) && (c != '%')) {
 			si++;
-		} else {
-			int w = 0, zp = 0, pp = 0;
+			c = fmt[si];
+		}
+		if (si > run) {
+			__fput(f, fmt + run, si - run);
+			total += si - run;
+		}
 
+		if (c == '%') {
 			si++;
-			if (str[si] == '#') {
-				pp = 1;
-				si++;
+			w = 0;
+			zp = 0;
+			alt = 0;
+			left = 0;
+			run = 1;
+			while (run) {
+				if (fmt[si] == '#')
+					alt = 1;
+				else if (fmt[si] == '0')
+					zp = 1;
+				else if (fmt[si] == '-')
+					left = 1;
+				else
+					run = 0;
+				si += run;
 			}
-			if (str[si] == '0') {
-				zp = 1;
+			if (left)
+				zp = 0;
+			while ((fmt[si] >= '0') && (fmt[si] <= '9')) {
+				w = (w * 10) + (fmt[si] - '0');
 				si++;
 			}
-			if (str[si] >= '1' && str[si] <= '9') {
-				w = str[si] - '0';
-				si++;
-				if (str[si] >= '0' && str[si] <= '9') {
-					w = w * 10;
-					w += str[si] - '0';
-					si++;
+
+			/* converted text is pfx then str[first..12) or str[0..n) */
+			c = fmt[si];
+			pfx = "";
+			plen = 0;
+			str = pb;
+			first = 0;
+			n = 0;
+			if (c == 'd') {
+				v = args[ai];
+				if (v < 0) {
+					pfx = "-";
+					plen = 1;
+					v = -v;
 				}
+				first = __render10(pb, v);
+				n = 12;
+			} else if (c == 'u') {
+				first = __render10(pb, args[ai]);
+				n = 12;
+			} else if ((c == 'x') || (c == 'p')) {
+				if ((alt == 1) || (c == 'p')) {
+					pfx = "0x";
+					plen = 2;
+				}
+				first = __render16(pb, args[ai]);
+				n = 12;
+			} else if (c == 's') {
+				str = args[ai];
+				n = strlen(str);
+				zp = 0;
+			} else if (c == 'c') {
+				pb[0] = args[ai];
+				n = 1;
+				zp = 0;
+			} else {
+				/* %% and unknown conversions print the character */
+				pb[0] = c;
+				n = 1;
+				zp = 0;
+				ai++;
 			}
-			if (str[si] == 's') {
-				/* append param pi as string */
-				int l = strlen(var_args[pi]);
-				strcpy(buffer + bi, var_args[pi]);
-				bi += l;
-			} else if (str[si] == 'd') {
-				/* append param as decimal */
-				int v = var_args[pi];
-				bi += __format(buffer + bi, v, w, zp, 10, 0);
-			} else if (str[si] == 'x') {
-				/* append param as hex */
-				int v = var_args[pi];
-				bi += __format(buffer + bi, v, w, zp, 16, pp);
-			}
-			pi--;
-			si++;
+			ai--;
+			if (c != 0)
+				si++;
+
+			n -= first;
+			w -= plen + n;
+			if ((zp == 0) && (left == 0) && (w > 0))
+				__fpad(f, ' ', w);
+			if (plen > 0)
+				__fput(f, pfx, plen);
+			if ((zp == 1) && (w > 0))
+				__fpad(f, '0', w);
+			__fput(f, str + first, n);
+			if ((left == 1) && (w > 0))
+				__fpad(f, ' ', w);
+			total += plen + n;
+			if (w > 0)
+				total += w;
 		}
 	}
-	buffer[bi] = 0;
-	__syscall(__syscall_write, 0, buffer, bi);
+	return total;
 }
 
-char *memcpy(char *dest, char *src, int count)
+int printf(char *fmt, ...)
 {
-	if (count > 0)
-		do {
-			count--;
-			dest[count] = src[count];
-		} while (count > 0);
-	return dest;
+	return __vfprintf(stdout, fmt, &fmt - 4);
 }
 
-void exit(int exit_code)
+int fprintf(FILE *stream, char *fmt, ...)
 {
-	__syscall(__syscall_exit, exit_code);
+	return __vfprintf(stream, fmt, &fmt - 4);
+}
+
+/* formats into str through a string stream holding at most size - 1 characters */
+int snprintf(char *str, int size, char *fmt, ...)
+{
+	FILE f;
+	int n;
+
+	f.buf = str;
+	f.mode = 3;
+	f.pos = 0;
+	f.len = 0;
+	if (size > 0)
+		f.len = size - 1;
+	n = __vfprintf(&f, fmt, &fmt - 4);
+	if (size > 0) {
+		if (n < f.len)
+			str[n] = 0;
+		else
+			str[f.len] = 0;
+	}
+	return n;
+}
+
+int sprintf(char *str, char *fmt, ...)
+{
+	FILE f;
+	int n;
+
+	f.buf = str;
+	f.mode = 3;
+	f.pos = 0;
+	f.len = 2147483647;
+	n = __vfprintf(&f, fmt, &fmt - 4);
+	str[n] = 0;
+	return n;
 }
 
 void abort()
 {
 	printf("Abnormal program termination\n");
+	fflush(stdout);
 	/* trigger SEGV - must be a better way */
 	int *z = 0;
 	z[0] = 0;
 	exit(-1);
 }
 
-FILE *fopen(char *filename, char *mode)
+/* blocks of 16 << class bytes with a 4 byte header holding the class, larger chunks hold their size */
+#define __HEAP_CLASSES 9
+#define __HEAP_LARGE 4096
+#define __HEAP_STEP 262144
+
+typedef struct {
+	char *top; /* next unused byte */
+	char *end; /* program break */
+	int bins[__HEAP_CLASSES]; /* free blocks of each class, linked through first word */
+	int large; /* free large chunks */
+} __heap_def;
+
+__heap_def *__heap;
+
+/* moves program break so at least size bytes follow heap top, 0 if out of memory */
+int __heap_grow(int size)
 {
-	if (strcmp(mode, "wb") == 0)
-		return __syscall(__syscall_open, filename, 65, 0x1c0);
-	else if (strcmp(mode, "rb") == 0)
-		return __syscall(__syscall_open, filename, 0, 0);
-	abort();
+	__heap_def *h = __heap;
+	char *end;
+	int step;
+
+	step = size - (h->end - h->top);
+	step = (step + 4095) - ((step + 4095) & 4095);
+	if (step < __HEAP_STEP)
+		step = __HEAP_STEP;
+	end = h->end + step;
+	if (__syscall(__syscall_brk, end) != end)
+		return 0;
+	h->end = end;
+	return 1;
 }
 
-int fclose(FILE *stream)
+/* places heap state at current break, payloads start 16 aligned */
+void __heap_init()
 {
-	__syscall(__syscall_close, stream);
-	return 0;
+	int base = __syscall(__syscall_brk, 0);
+	int i;
+
+	base = (base + 15) - ((base + 15) & 15);
+	__heap = base;
+	__heap->end = base;
+	__heap->top = base + sizeof(__heap_def) + 12; /* first header, payload 16 aligned */
+	for (i = 0; i < __HEAP_CLASSES; i++)
+		__heap->bins[i] = 0;
+	__heap->large = 0;
 }
 
-int fgetc(FILE *stream)
+/* takes size bytes from heap top */
+char *__heap_take(int size)
 {
-	char buf;
-	int r = __syscall(__syscall_read, stream, &buf, 1);
-	if (r <= 0)
-		return -1;
-	return buf;
+	__heap_def *h = __heap;
+	char *block = h->top;
+
+	if ((h->end - block) < size)
+		if (__heap_grow(size) == 0)
+			return NULL;
+	h->top = block + size;
+	return block;
 }
 
-char *fgets(char *str, int n, FILE *stream)
+void *malloc(int size)
 {
-	int i = 0;
-	char c;
-	do {
-		c = fgetc(stream);
-		if (c == -1 || c == 255) {
-			if (i == 0)
-				/* EOF on first char */
-				return NULL;
-			else
-				/* EOF in the middle */
-				str[i] = 0;
-			return str;
+	__heap_def *h;
+	int *block;
+	int *prev;
+	int c = 0, s = 16;
+
+	if (__heap == NULL)
+		__heap_init();
+	h = __heap;
+	size += 4;
+
+	if (size > __HEAP_LARGE) {
+		/* first fit among freed chunks, else a new one rounded to a page */
+		size = (size + 4095) - ((size + 4095) & 4095);
+		prev = &h->large;
+		block = h->large;
+		while (block != NULL) {
+			if (block[0] >= size) {
+				prev[0] = block[1];
+				return block + 1;
+			}
+			prev = block + 1;
+			block = block[1];
 		}
-		str[i] = c;
-		i++;
-	} while (str[i - 1] != '\n');
-	str[i] = 0;
-	return str;
+		block = __heap_take(size);
+		if (block == NULL)
+			return NULL;
+		block[0] = size;
+		return block + 1;
+	}
+
+	while (s < size) {
+		s = s << 1;
+		c++;
+	}
+	block = h->bins[c];
+	if (block != NULL) {
+		h->bins[c] = block[1];
+		return block + 1;
+	}
+	block = __heap_take(s);
+	if (block == NULL)
+		return NULL;
+	block[0] = c;
+	return block + 1;
 }
 
-int fputc(int c, FILE *stream)
+void free(void *ptr)
 {
-	char buf[1];
-	buf[0] = c;
-	__syscall(__syscall_write, stream, &buf, 1);
-	return 0;
+	__heap_def *h = __heap;
+	int *block;
+
+	if (ptr == NULL)
+		return;
+	block = ptr - 4;
+	if (block[0] < __HEAP_CLASSES) {
+		block[1] = h->bins[block[0]];
+		h->bins[block[0]] = block;
+	} else {
+		block[1] = h->large;
+		h->large = block;
+	}
 }
 
-int fputs(char *str, FILE *stream)
+/* bytes usable in block at ptr */
+int __heap_size(void *ptr)
 {
-	int i = 0;
-	while (str[i] != 0) {
-		fputc(str[i], stream);
-		i++;
-	}
-	return i;
+	int *block = ptr - 4;
+
+	if (block[0] < __HEAP_CLASSES)
+		return (16 << block[0]) - 4;
+	return (block[0]) - 4;
 }
 
-void *malloc(int size)
+void *calloc(int count, int size)
 {
-	int brk = __syscall(__syscall_brk, 0); /* read current break */
-	__syscall(__syscall_brk, brk + size); /* increment */
-	return brk; /* return previous location, now extended by size */
+	char *p = malloc(count * size);
+
+	if (p == NULL)
+		return NULL;
+	memset(p, 0, __heap_size(p));
+	return p;
+}
+
+void *realloc(void *ptr, int size)
+{
+	void *p;
+	int n;
+
+	if (ptr == NULL)
+		return malloc(size);
+	n = __heap_size(ptr);
+	if (size <= n)
+		return ptr;
+	p = malloc(size);
+	if (p == NULL)
+		return NULL;
+	memcpy(p, ptr, n);
+	free(ptr);
+	return p;
 }
@@ -59,6 +59,21 @@ typedef enum {
 	a_pc = 15
 } a_reg;
 
+/* ARMv7 literal pool entry kinds */
+typedef enum { ap_number = 0, ap_data = 1, ap_rodata = 2 } ap_kind;
+
+/* literal pool of function being sized or generated */
+typedef struct {
+	int kinds[MAX_POOL];
+	int values[MAX_POOL];
+	int size;
+	int active; /* function being sized loads from its pool */
+	int end; /* its exit point IL index */
+	function_def *function; /* function entries belong to while generating */
+} a_pool_def;
+
+a_pool_def *_a_pool;
+
 ar_cond a_get_cond(il_op op)
 {
 	switch (op) {
@@ -103,20 +118,29 @@ int a_swi()
 	return a_encode(ac_al, 240, 0, 0, 0);
 }
 
+/* 8-bit value rotated right by an even amount as rotation << 8 + value, -1 if impossible */
+int a_rotated_imm(int val)
+{
+	int rot = 0, imm = -1;
+
+	while (rot < 16 && imm < 0) {
+		if (val >= 0 && val < 256)
+			imm = (rot << 8) + val;
+		/* rotate left by two bits */
+		val = (val << 2) | ((val >> 30) & 3);
+		rot++;
+	}
+	return imm;
+}
+
 int a_mov(ar_cond cond, int io, int opcode, int s, int rn, int rd, int op2)
 {
-	int shift = 0;
-	if (op2 > 255) {
-		shift = 16; /* full rotation */
-		while ((op2 & 3) == 0) {
-			/* we can shift by two bits */
-			op2 = op2 >> 2;
-			shift -= 1;
-		}
-		if (op2 > 255)
+	if (io && (op2 < 0 || op2 > 255)) {
+		op2 = a_rotated_imm(op2);
+		if (op2 < 0)
 			error("Unable to represent value"); /* value spans more than 8 bits */
 	}
-	return a_encode(cond, s + (opcode << 1) + (io << 5), rn, rd, (shift << 8) + (op2 & 255));
+	return a_encode(cond, s + (opcode << 1) + (io << 5), rn, rd, op2);
 }
 
 int a_and_i(ar_cond cond, a_reg rd, a_reg rs, int imm)
@@ -155,6 +179,11 @@ int a_mov_i(ar_cond cond, a_reg rd, int imm)
 	return a_mov(cond, 1, ar_mov, 0, 0, rd, imm);
 }
 
+int a_mvn_i(ar_cond cond, a_reg rd, int imm)
+{
+	return a_mov(cond, 1, ar_mvn, 0, 0, rd, imm);
+}
+
 int a_mov_r(ar_cond cond, a_reg rd, a_reg rs)
 {
 	return a_mov(cond, 0, ar_mov, 0, 0, rd, rs);
@@ -277,6 +306,18 @@ int a_teq(a_reg rd)
 	return a_mov(ac_al, 1, ar_teq, 1, rd, 0, 0);
 }
 
+/* cycles before the result of an IL instruction can be used without stalling an in-order pipeline */
+int a_get_latency(il_instr *ii)
+{
+	switch (ii->op) {
+	case op_read_addr:
+	case op_mul:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
 int a_elf_machine()
 {
 	return 0x28;
@@ -287,31 +328,203 @@ int a_elf_flags()
 	return 0x5000200;
 }
 
+/* patches instruction or word at idx in buf to refer to value v from place p, 0 if type is not supported */
+int a_elf_relocate(char *buf, int idx, int type, int v, int p)
+{
+	int w = e_read_int(buf, idx);
+	int cond = (w >> 28) & 15;
+	int rd = (w >> 12) & 15;
+
+	switch (type) {
+	case R_ARM_NONE:
+	case R_ARM_V4BX:
+		return 1;
+	case R_ARM_ABS32:
+		e_write_int(buf, idx, v);
+		return 1;
+	case R_ARM_REL32:
+		e_write_int(buf, idx, v - p);
+		return 1;
+	case R_ARM_PREL31:
+		e_write_int(buf, idx, (w - (w & 2147483647)) + ((v - p) & 2147483647));
+		return 1;
+	case R_ARM_CALL:
+		/* bl, or blx into Thumb code selecting the halfword */
+		if ((v & 1) != 0)
+			cond = 15;
+		w = w & (0 - 16777216);
+		if (cond == 15)
+			w = (0 - 100663296) + (((v - p) & 2) << 23); /* 0xFA000000 */
+		e_write_int(buf, idx, w + (((v - p) >> 2) & 16777215));
+		return 1;
+	case R_ARM_JUMP24:
+		if ((v & 1) != 0)
+			error("Branch into Thumb code");
+		e_write_int(buf, idx, (w & (0 - 16777216)) + (((v - p) >> 2) & 16777215));
+		return 1;
+	case R_ARM_MOVW_ABS_NC:
+		e_write_int(buf, idx, a_movw(cond, rd, v));
+		return 1;
+	case R_ARM_MOVT_ABS:
+		e_write_int(buf, idx, a_movt(cond, rd, v));
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* sign extends low bits of value */
+int a_sign_extend(int val, int bits)
+{
+	if ((val & (1 << (bits - 1))) != 0)
+		return val - (1 << bits);
+	return val;
+}
+
+/* addend held by instruction or word in place, as objects of gcc and clang keep them in REL entries */
+int a_elf_addend(char *buf, int idx, int type)
+{
+	int w = e_read_int(buf, idx);
+
+	switch (type) {
+	case R_ARM_ABS32:
+	case R_ARM_REL32:
+		return w;
+	case R_ARM_PREL31:
+		return a_sign_extend(w & 2147483647, 31);
+	case R_ARM_CALL:
+	case R_ARM_JUMP24:
+		return a_sign_extend(w & 16777215, 24) * 4;
+	case R_ARM_MOVW_ABS_NC:
+	case R_ARM_MOVT_ABS:
+		return a_sign_extend(((w >> 4) & 61440) + (w & 4095), 16);
+	default:
+		return 0;
+	}
+}
+
 int a_dest_reg(int param_no)
 {
 	return param_no;
 }
 
+/* constant loaded by a single mov, mvn or movw */
+int a_short_constant(int val)
+{
+	if (a_rotated_imm(val) >= 0 || a_rotated_imm(-val - 1) >= 0)
+		return 1;
+	if (val >= 0 && val < 65536)
+		return 1;
+	return 0;
+}
+
+/* kind of literal pool entry instruction would load, -1 if none */
+int a_pool_kind(il_instr *ii)
+{
+	variable_def *var;
+
+	switch (ii->op) {
+	case op_load_numeric_constant:
+		if (a_short_constant(ii->int_param1))
+			return -1;
+		return ap_number;
+	case op_load_data_address:
+		return ap_rodata;
+	case op_get_var_addr:
+		var = find_global_variable(ii->string_param1);
+		if (var != NULL)
+			if (var->init >= 0)
+				return ap_data;
+		return -1;
+	default:
+		return -1;
+	}
+	return -1;
+}
+
+/* constant, data offset or literal offset of literal pool entry */
+int a_pool_value(il_instr *ii)
+{
+	variable_def *var;
+
+	if (ii->op == op_get_var_addr) {
+		var = find_global_variable(ii->string_param1);
+		return var->offset;
+	}
+	return ii->int_param1;
+}
+
+/* index of entry in literal pool, added if new, -1 if pool is full */
+int a_pool_slot(int kind, int value)
+{
+	int i;
+
+	for (i = 0; i < _a_pool->size; i++)
+		if (_a_pool->kinds[i] == kind && _a_pool->values[i] == value)
+			return i;
+	if (_a_pool->size >= MAX_POOL)
+		return -1;
+	_a_pool->kinds[_a_pool->size] = kind;
+	_a_pool->values[_a_pool->size] = value;
+	return _a_pool->size++;
+}
+
+int a_get_code_length(il_instr *ii);
+int t_elf_relocate(char *buf, int idx, int type, int v, int p);
+int t_elf_addend(char *buf, int idx, int type);
+
+/* use a literal pool after function exit if all of function can reach it */
+void a_plan_pool(function_def *fn)
+{
+	int i, kind, size = 0;
+
+	_a_pool->size = 0;
+	_a_pool->active = 1;
+	_a_pool->end = fn->exit_point;
+	_a_pool->function = NULL;
+	for (i = fn->entry_point + 1; i <= fn->exit_point; i++) {
+		kind = a_pool_kind(&_il[i]);
+		if (kind >= 0)
+			if (a_pool_slot(kind, a_pool_value(&_il[i])) < 0)
+				_a_pool->active = 0;
+	}
+	fn->pool_size = _a_pool->size;
+
+	/* ldr reaches 4KB from pc */
+	if (_a_pool->active)
+		for (i = fn->entry_point + 1; i <= fn->exit_point; i++)
+			size += a_get_code_length(&_il[i]);
+	if (size >= 4000 || _a_pool->size == 0)
+		_a_pool->active = 0;
+	if (_a_pool->active == 0)
+		fn->pool_size = 0;
+}
+
 int a_get_code_length(il_instr *ii)
 {
 	il_op op = ii->op;
 	function_def *fn;
 	block_def *bd;
+	int len;
 
 	switch (op) {
 	case op_entry_point:
 		fn = find_function(ii->string_param1);
-		return 16 + (fn->num_params << 2);
+		a_plan_pool(fn);
+		return 16 + (((fn->num_params + fn->cache_regs) + fn->saved_params) << 2);
 	case op_function_call:
 	case op_pointer_call:
 		if (ii->param_no != 0)
 			return 8;
 		return 4;
 	case op_load_numeric_constant:
-		if (ii->int_param1 >= 0 && ii->int_param1 < 256)
+	case op_load_data_address:
+	case op_get_var_addr:
+		if (op == op_load_numeric_constant && a_short_constant(ii->int_param1))
 			return 4;
-		else
-			return 8;
+		if (_a_pool->active && ii->il_index < _a_pool->end && a_pool_kind(ii) >= 0)
+			return 4;
+		return 8;
 	case op_block_start:
 	case op_block_end:
 		bd = &_blocks[ii->int_param1];
@@ -327,21 +540,32 @@ int a_get_code_length(il_instr *ii)
 	case op_greater_eq_than:
 		return 12;
 	case op_syscall:
-		return 20;
+		len = 4;
+		if (ii->int_param2 < 0)
+			len += ii->int_param1 << 2;
+		else if (a_short_constant(ii->int_param2))
+			len += 4;
+		else
+			len += 8;
+		if (ii->param_no != 0)
+			len += 4;
+		return len;
 	case op_exit_point:
-		return 16;
+		fn = find_function(ii->string_param1);
+		return 16 + (((fn->cache_regs + fn->saved_params) + fn->pool_size) << 2);
+	case op_tail_call:
+		return 16 + (ii->int_param2 << 2);
 	case op_exit:
 		return 12;
-	case op_load_data_address:
 	case op_jz:
 	case op_jnz:
 	case op_push:
 	case op_pop:
-	case op_get_var_addr:
 	case op_start:
 		return 8;
 	case op_jump:
 	case op_return:
+	case op_move:
 	case op_generic:
 	case op_add:
 	case op_sub:
@@ -365,18 +589,59 @@ int a_get_code_length(il_instr *ii)
 	return 0;
 }
 
+/* does function being generated load constants from its literal pool */
+int a_pool_used(backend_state *state)
+{
+	if (state->function != NULL)
+		if (state->function->pool_size > 0)
+			return 1;
+	return 0;
+}
+
+/* loads entry of function's literal pool, placed after its exit code */
+void a_pool_load(backend_state *state, int kind, int value)
+{
+	function_def *fn = state->function;
+	int ofs;
+
+	if (_a_pool->function != fn) {
+		_a_pool->function = fn;
+		_a_pool->size = 0;
+	}
+	ofs = _il[fn->exit_point].code_offset + 16 + ((fn->cache_regs + fn->saved_params) << 2);
+	ofs += a_pool_slot(kind, value) << 2;
+	c_emit(a_lw(ac_al, state->dest_reg, a_pc, ofs - state->pc - 8));
+}
+
+/* loads absolute address, relocated if it refers to a symbol of an object file */
+void a_load_address(backend_state *state, int val)
+{
+	c_reloc(state, R_ARM_MOVW_ABS_NC, 0);
+	c_emit(a_movw(ac_al, state->dest_reg, val));
+	c_reloc(state, R_ARM_MOVT_ABS, 0);
+	c_emit(a_movt(ac_al, state->dest_reg, val));
+}
+
 void a_op_load_data_address(backend_state *state, int ofs)
 {
-	ofs += state->code_start;
-	c_emit(a_movw(ac_al, state->dest_reg, ofs));
-	c_emit(a_movt(ac_al, state->dest_reg, ofs));
+	if (a_pool_used(state)) {
+		a_pool_load(state, ap_rodata, ofs - _e_rodata_start);
+		return;
+	}
+	a_load_address(state, ofs + state->code_start);
 }
 
 void a_op_load_numeric_constant(backend_state *state, int val)
 {
-	if (val >= 0 && val < 256) {
+	if (a_rotated_imm(val) >= 0)
 		c_emit(a_mov_i(ac_al, state->dest_reg, val));
-	} else {
+	else if (a_rotated_imm(-val - 1) >= 0)
+		c_emit(a_mvn_i(ac_al, state->dest_reg, -val - 1));
+	else if (val >= 0 && val < 65536)
+		c_emit(a_movw(ac_al, state->dest_reg, val));
+	else if (a_pool_used(state))
+		a_pool_load(state, ap_number, val);
+	else {
 		c_emit(a_movw(ac_al, state->dest_reg, val));
 		c_emit(a_movt(ac_al, state->dest_reg, val));
 	}
@@ -384,10 +649,14 @@ void a_op_load_numeric_constant(backend_state *state, int val)
 
 void a_op_get_global_addr(backend_state *state, int ofs)
 {
+	/* pool only holds data offsets, a global of another object is loaded by movw and movt */
+	if (a_pool_used(state) && (state->reloc_symbol < E_SYM_LOCALS)) {
+		a_pool_load(state, ap_data, ofs - state->data_start);
+		return;
+	}
+
 	/* need to find the variable offset in data section, absolute */
-	ofs += state->code_start;
-	c_emit(a_movw(ac_al, state->dest_reg, ofs));
-	c_emit(a_movt(ac_al, state->dest_reg, ofs));
+	a_load_address(state, ofs + state->code_start);
 }
 
 void a_op_get_local_addr(backend_state *state, int offset)
@@ -398,8 +667,7 @@ void a_op_get_local_addr(backend_state *state, int offset)
 
 void a_op_get_function_addr(backend_state *state, int ofs)
 {
-	c_emit(a_movw(ac_al, state->dest_reg, ofs));
-	c_emit(a_movt(ac_al, state->dest_reg, ofs));
+	a_load_address(state, ofs);
 }
 
 void a_op_read_addr(backend_state *state, int len)
@@ -442,11 +710,20 @@ void a_op_return(int ofs)
 
 void a_op_function_call(backend_state *state, int ofs)
 {
+	c_reloc(state, R_ARM_CALL, -8);
 	c_emit(a_bl(ac_al, ofs));
 	if (state->dest_reg != a_r0)
 		c_emit(a_mov_r(ac_al, state->dest_reg, a_r0));
 }
 
+void a_op_tail_call(int ofs)
+{
+	c_emit(a_add_i(ac_al, a_sp, a_s0, 16));
+	c_emit(a_lw(ac_al, a_lr, a_sp, -8));
+	c_emit(a_lw(ac_al, a_s0, a_sp, -4));
+	c_emit(a_b(ac_al, ofs - 12));
+}
+
 void a_op_pointer_call(backend_state *state)
 {
 	c_emit(a_blx(ac_al, state->op_reg));
@@ -454,6 +731,11 @@ void a_op_pointer_call(backend_state *state)
 		c_emit(a_mov_r(ac_al, state->dest_reg, a_r0));
 }
 
+void a_op_move(backend_state *state)
+{
+	c_emit(a_mov_r(ac_al, state->dest_reg, state->op_reg));
+}
+
 void a_op_push(backend_state *state)
 {
 	c_emit(a_add_i(ac_al, a_sp, a_sp, -16)); /* 16 aligned although we only need 4 */
@@ -474,6 +756,30 @@ void a_op_exit_point()
 	c_emit(a_mov_r(ac_al, a_pc, a_lr));
 }
 
+void a_op_literal_pool(backend_state *state)
+{
+	int i, val, kind, base;
+
+	if (a_pool_used(state) == 0 || _a_pool->function != state->function)
+		return;
+	for (i = 0; i < _a_pool->size; i++) {
+		val = _a_pool->values[i];
+		kind = _a_pool->kinds[i];
+		if (kind != ap_number) {
+			/* address within data or read-only data, both relocated */
+			base = state->data_start;
+			if (kind == ap_rodata) {
+				base = _e_rodata_start;
+				e_reloc_rodata(state, val);
+			} else
+				e_reloc_data(state, val);
+			c_reloc(state, R_ARM_ABS32, 0);
+			val += state->code_start + base;
+		}
+		c_emit(val);
+	}
+}
+
 void a_op_alu(backend_state *state, il_op op)
 {
 	switch (op) {
@@ -569,19 +875,38 @@ void a_op_store_param(int pn, int ofs)
 	c_emit(a_sw(ac_al, a_r0 + pn, a_s0, ofs));
 }
 
+void a_op_load_param(int pn, int ofs)
+{
+	c_emit(a_lw(ac_al, a_r0 + pn, a_s0, ofs));
+}
+
 void a_op_start()
 {
 	c_emit(a_lw(ac_al, a_r0, a_sp, 0)); /* argc */
 	c_emit(a_add_i(ac_al, a_r1, a_sp, 4)); /* argv */
 }
 
-void a_op_syscall()
+/* number goes in r7 and arguments from r0, result comes back in r0 */
+void a_op_syscall(backend_state *state, int number, int args)
 {
-	c_emit(a_mov_r(ac_al, a_r7, a_r0));
-	c_emit(a_mov_r(ac_al, a_r0, a_r1));
-	c_emit(a_mov_r(ac_al, a_r1, a_r2));
-	c_emit(a_mov_r(ac_al, a_r2, a_r3));
+	int i, rd = state->dest_reg;
+
+	if (number < 0) {
+		/* computed number is in r0, arguments after it */
+		c_emit(a_mov_r(ac_al, a_r7, a_r0));
+		for (i = 1; i < args; i++)
+			c_emit(a_mov_r(ac_al, a_r0 + i - 1, a_r0 + i));
+	} else if (a_short_constant(number)) {
+		state->dest_reg = a_r7;
+		a_op_load_numeric_constant(state, number);
+		state->dest_reg = rd;
+	} else {
+		c_emit(a_movw(ac_al, a_r7, number));
+		c_emit(a_movt(ac_al, a_r7, number));
+	}
 	c_emit(a_swi());
+	if (rd != a_r0)
+		c_emit(a_mov_r(ac_al, rd, a_r0));
 }
 
 void a_op_exit()
@@ -595,10 +920,21 @@ void a_initialize_backend(backend_def *be)
 {
 	be->arch = a_arm;
 	be->source_define = "__ARM";
+	be->cache_regs = 3; /* r8-r10 */
+	be->first_saved_param = 4; /* r4-r7 */
+	_a_pool = malloc(sizeof(a_pool_def));
+	_a_pool->active = 0;
+	_a_pool->function = NULL;
+	be->global_reg = 0;
 	be->elf_machine = a_elf_machine;
 	be->elf_flags = a_elf_flags;
+	be->elf_word_reloc = R_ARM_ABS32;
+	/* objects linked in may hold Thumb code, its relocations are patched by the Thumb encoder */
+	be->elf_relocate = t_elf_relocate;
+	be->elf_addend = t_elf_addend;
 	be->c_dest_reg = a_dest_reg;
 	be->c_get_code_length = a_get_code_length;
+	be->c_get_latency = a_get_latency;
 	be->op_load_data_address = a_op_load_data_address;
 	be->op_load_numeric_constant = a_op_load_numeric_constant;
 	be->op_get_global_addr = a_op_get_global_addr;
@@ -606,13 +942,18 @@ void a_initialize_backend(backend_def *be)
 	be->op_get_function_addr = a_op_get_function_addr;
 	be->op_read_addr = a_op_read_addr;
 	be->op_write_addr = a_op_write_addr;
+	be->op_read_global = NULL; /* no global register */
+	be->op_write_global = NULL;
 	be->op_jump = a_op_jump;
 	be->op_return = a_op_return;
 	be->op_function_call = a_op_function_call;
 	be->op_pointer_call = a_op_pointer_call;
+	be->op_tail_call = a_op_tail_call;
+	be->op_move = a_op_move;
 	be->op_push = a_op_push;
 	be->op_pop = a_op_pop;
 	be->op_exit_point = a_op_exit_point;
+	be->op_literal_pool = a_op_literal_pool;
 	be->op_alu = a_op_alu;
 	be->op_cmp = a_op_cmp;
 	be->op_log = a_op_log;
@@ -621,6 +962,7 @@ void a_initialize_backend(backend_def *be)
 	be->op_block = a_op_block;
 	be->op_entry_point = a_op_entry_point;
 	be->op_store_param = a_op_store_param;
+	be->op_load_param = a_op_load_param;
 	be->op_start = a_op_start;
 	be->op_syscall = a_op_syscall;
 	be->op_exit = a_op_exit;
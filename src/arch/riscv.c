@@ -87,6 +87,15 @@ typedef enum {
 	r_t6 = 31
 } r_reg;
 
+/* high parts of pc-relative addresses linked in, by place of their auipc */
+typedef struct {
+	int places[MAX_PCREL];
+	int offsets[MAX_PCREL];
+	int size;
+} r_pcrel_def;
+
+r_pcrel_def *_r_pcrel;
+
 int r_extract_bits(int imm, int i_start, int i_end, int d_start, int d_end)
 {
 	int v;
@@ -383,6 +392,216 @@ int r_mul(r_reg rd, r_reg rs1, r_reg rs2)
 	return r_encode_R(ri_mul, rd, rs1, rs2);
 }
 
+/* are 16-bit compressed instructions enabled */
+int r_compressed()
+{
+	if (_backend->arch == a_riscv_c)
+		return 1;
+	return 0;
+}
+
+/* registers x8-x15 addressable by 3-bit fields of compressed instructions */
+int r_compact_reg(r_reg r)
+{
+	if (r >= r_s0 && r <= r_a5)
+		return 1;
+	return 0;
+}
+
+int r_encode_CR(int funct4, r_reg rd, r_reg rs2)
+{
+	return (funct4 << 12) + (rd << 7) + (rs2 << 2) + 2;
+}
+
+int r_encode_CI(int funct3, r_reg rd, int imm, int op)
+{
+	return (funct3 << 13) + r_extract_bits(imm, 5, 5, 12, 12) + (rd << 7) + r_extract_bits(imm, 0, 4, 2, 6) + op;
+}
+
+int r_encode_CA(int funct2, r_reg rd, r_reg rs2)
+{
+	return (35 << 10) + ((rd - r_s0) << 7) + (funct2 << 5) + ((rs2 - r_s0) << 2) + 1;
+}
+
+int r_encode_CL(int funct3, r_reg rs1, r_reg rd, int imm)
+{
+	return (funct3 << 13) + r_extract_bits(imm, 3, 5, 10, 12) + ((rs1 - r_s0) << 7) + r_extract_bits(imm, 2, 2, 6, 6) +
+	       r_extract_bits(imm, 6, 6, 5, 5) + ((rd - r_s0) << 2);
+}
+
+/* c.beqz, c.bnez */
+int r_encode_CB(int funct3, r_reg rs1, int imm)
+{
+	return (funct3 << 13) + r_extract_bits(imm, 8, 8, 12, 12) + r_extract_bits(imm, 3, 4, 10, 11) + ((rs1 - r_s0) << 7) +
+	       r_extract_bits(imm, 6, 7, 5, 6) + r_extract_bits(imm, 1, 2, 3, 4) + r_extract_bits(imm, 5, 5, 2, 2) + 1;
+}
+
+/* c.j, c.jal */
+int r_encode_CJ(int funct3, int imm)
+{
+	return (funct3 << 13) + r_extract_bits(imm, 11, 11, 12, 12) + r_extract_bits(imm, 4, 4, 11, 11) +
+	       r_extract_bits(imm, 8, 9, 9, 10) + r_extract_bits(imm, 10, 10, 8, 8) + r_extract_bits(imm, 6, 6, 7, 7) +
+	       r_extract_bits(imm, 7, 7, 6, 6) + r_extract_bits(imm, 1, 3, 3, 5) + r_extract_bits(imm, 5, 5, 2, 2) + 1;
+}
+
+/* 16-bit form of a 32-bit instruction, -1 if it has none */
+int r_compress(int instr)
+{
+	int kind = instr & 28799; /* opcode and funct3 */
+	int rd = (instr >> 7) & 31, rs1 = (instr >> 15) & 31, rs2 = (instr >> 20) & 31, f7 = (instr >> 25) & 127;
+	int imm = (instr >> 20) & 4095, funct2;
+
+	if (imm > 2047)
+		imm -= 4096;
+
+	switch (kind) {
+	case ri_addi:
+		if (rd == r_zero && rs1 == r_zero && imm == 0)
+			return 1; /* c.nop */
+		if (rd != r_zero && rs1 == r_zero && imm >= -32 && imm < 32)
+			return r_encode_CI(2, rd, imm, 1); /* c.li */
+		if (rd == r_sp && rs1 == r_sp && imm != 0 && (imm & 15) == 0 && imm >= -512 && imm < 512)
+			/* c.addi16sp */
+			return (3 << 13) + r_extract_bits(imm, 9, 9, 12, 12) + (r_sp << 7) + r_extract_bits(imm, 4, 4, 6, 6) +
+			       r_extract_bits(imm, 6, 6, 5, 5) + r_extract_bits(imm, 7, 8, 3, 4) + r_extract_bits(imm, 5, 5, 2, 2) + 1;
+		if (rd != r_zero && rd == rs1 && imm != 0 && imm >= -32 && imm < 32)
+			return r_encode_CI(0, rd, imm, 1); /* c.addi */
+		if (rs1 == r_sp && r_compact_reg(rd) && imm > 0 && imm < 1024 && (imm & 3) == 0)
+			/* c.addi4spn */
+			return r_extract_bits(imm, 4, 5, 11, 12) + r_extract_bits(imm, 6, 9, 7, 10) + r_extract_bits(imm, 2, 2, 6, 6) +
+			       r_extract_bits(imm, 3, 3, 5, 5) + ((rd - r_s0) << 2);
+		if (rd != r_zero && rs1 != r_zero && imm == 0)
+			return r_encode_CR(8, rd, rs1); /* c.mv */
+		return -1;
+	case ri_lw:
+		if (rs1 == r_sp && rd != r_zero && imm >= 0 && imm < 256 && (imm & 3) == 0)
+			/* c.lwsp */
+			return (2 << 13) + r_extract_bits(imm, 5, 5, 12, 12) + (rd << 7) + r_extract_bits(imm, 2, 4, 4, 6) +
+			       r_extract_bits(imm, 6, 7, 2, 3) + 2;
+		if (r_compact_reg(rs1) && r_compact_reg(rd) && imm >= 0 && imm < 128 && (imm & 3) == 0)
+			return r_encode_CL(2, rs1, rd, imm); /* c.lw */
+		return -1;
+	case ri_sw:
+		/* store offset is split around rs1 and rs2 */
+		imm = (f7 << 5) + rd;
+		if (imm > 2047)
+			imm -= 4096;
+		if (rs1 == r_sp && imm >= 0 && imm < 256 && (imm & 3) == 0)
+			/* c.swsp */
+			return (6 << 13) + r_extract_bits(imm, 2, 5, 9, 12) + r_extract_bits(imm, 6, 7, 7, 8) + (rs2 << 2) + 2;
+		if (r_compact_reg(rs1) && r_compact_reg(rs2) && imm >= 0 && imm < 128 && (imm & 3) == 0)
+			return r_encode_CL(6, rs1, rs2, imm); /* c.sw */
+		return -1;
+	case ri_beq:
+	case ri_bne:
+		/* branch offset is split around the registers */
+		imm = r_extract_bits(instr, 8, 11, 1, 4) + r_extract_bits(instr, 25, 30, 5, 10) + r_extract_bits(instr, 7, 7, 11, 11);
+		if (((instr >> 31) & 1) != 0)
+			imm -= 4096;
+		if (rs2 == r_zero && r_compact_reg(rs1) && imm >= -256 && imm < 256) {
+			/* c.beqz, c.bnez */
+			funct2 = 6;
+			if (kind == ri_bne)
+				funct2 = 7;
+			return r_encode_CB(funct2, rs1, imm);
+		}
+		return -1;
+	case ri_jalr:
+		if (rs1 != r_zero && imm == 0 && rd == r_zero)
+			return r_encode_CR(8, rs1, r_zero); /* c.jr */
+		if (rs1 != r_zero && imm == 0 && rd == r_ra)
+			return r_encode_CR(9, rs1, r_zero); /* c.jalr */
+		return -1;
+	default:
+		break;
+	}
+
+	if ((instr & 127) == ri_jal) {
+		imm = r_extract_bits(instr, 21, 30, 1, 10) + r_extract_bits(instr, 20, 20, 11, 11) + r_extract_bits(instr, 12, 19, 12, 19);
+		if (((instr >> 31) & 1) != 0)
+			imm -= 2097152;
+		if ((rd == r_zero || rd == r_ra) && imm >= -2048 && imm < 2048) {
+			/* c.j, c.jal */
+			funct2 = 5;
+			if (rd == r_ra)
+				funct2 = 1;
+			return r_encode_CJ(funct2, imm);
+		}
+		return -1;
+	}
+
+	if ((instr & 127) == ri_lui) {
+		/* 20-bit upper immediate */
+		imm = (instr >> 12) & 1048575;
+		if (imm > 524287)
+			imm -= 1048576;
+		if (rd != r_zero && rd != r_sp && imm != 0 && imm >= -32 && imm < 32)
+			return r_encode_CI(3, rd, imm, 1); /* c.lui */
+		return -1;
+	}
+
+	/* register-register ops, either source can be the destination when commutative */
+	if ((instr & 127) == ri_add && rd != r_zero) {
+		if (kind == ri_add && f7 == 0) {
+			if (rd == rs1 && rs2 != r_zero)
+				return r_encode_CR(9, rd, rs2); /* c.add */
+			if (rd == rs2 && rs1 != r_zero)
+				return r_encode_CR(9, rd, rs1);
+			if (rs1 == r_zero && rs2 != r_zero)
+				return r_encode_CR(8, rd, rs2); /* c.mv */
+		}
+		if (kind == ri_add && f7 == 32 && rd == rs1 && r_compact_reg(rd) && r_compact_reg(rs2))
+			return r_encode_CA(0, rd, rs2); /* c.sub */
+		if (f7 == 0 && r_compact_reg(rd) && (kind == ri_xor || kind == ri_or || kind == ri_and)) {
+			/* c.xor, c.or, c.and */
+			funct2 = 3;
+			if (kind == ri_xor)
+				funct2 = 1;
+			else if (kind == ri_or)
+				funct2 = 2;
+			if (rd == rs1 && r_compact_reg(rs2))
+				return r_encode_CA(funct2, rd, rs2);
+			if (rd == rs2 && r_compact_reg(rs1))
+				return r_encode_CA(funct2, rd, rs1);
+		}
+	}
+	return -1;
+}
+
+/* emits instruction, as its 16-bit form when compressed instructions are enabled */
+void r_emit(int instr)
+{
+	int c = -1;
+
+	if (r_compressed())
+		c = r_compress(instr);
+	if (c >= 0)
+		c_emit_short(c);
+	else
+		c_emit(instr);
+}
+
+/* length of instruction once emitted */
+int r_size(int instr)
+{
+	if (r_compressed())
+		if (r_compress(instr) >= 0)
+			return 2;
+	return 4;
+}
+
+/* cycles before the result of an IL instruction can be used without stalling an in-order pipeline */
+int r_get_latency(il_instr *ii)
+{
+	switch (ii->op) {
+	case op_read_addr:
+	case op_mul:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
 int r_elf_machine()
 {
 	return 0xf3;
@@ -390,24 +609,126 @@ int r_elf_machine()
 
 int r_elf_flags()
 {
+	if (r_compressed())
+		return 0x5000201; /* EF_RISCV_RVC */
 	return 0x5000200;
 }
 
+/* pc-relative offset auipc at place p loads, for the instructions after it that refer to its label */
+int r_pcrel_offset(int p)
+{
+	int i;
+
+	for (i = 0; i < _r_pcrel->size; i++)
+		if (_r_pcrel->places[i] == p)
+			return _r_pcrel->offsets[i];
+	error("Missing pc-relative high part");
+	return 0;
+}
+
+/* patches instruction or word at idx in buf to refer to value v from place p, 0 if type is not supported */
+int r_elf_relocate(char *buf, int idx, int type, int v, int p)
+{
+	int w = e_read_int(buf, idx);
+
+	switch (type) {
+	case R_RISCV_NONE:
+	case R_RISCV_ALIGN:
+	case R_RISCV_RELAX:
+		/* no linker relaxation, code stays as laid out */
+		return 1;
+	case R_RISCV_32:
+		e_write_int(buf, idx, v);
+		return 1;
+	case R_RISCV_BRANCH:
+		e_write_int(buf, idx, (w & 0x01FFF07F) + r_encode_B(0, 0, 0, v - p));
+		return 1;
+	case R_RISCV_JAL:
+		e_write_int(buf, idx, (w & 4095) + r_encode_J(0, 0, v - p));
+		return 1;
+	case R_RISCV_HI20:
+		e_write_int(buf, idx, (w & 4095) + r_encode_U(0, 0, r_hi(v)));
+		return 1;
+	case R_RISCV_LO12_I:
+		e_write_int(buf, idx, (w & 1048575) + r_encode_I(0, 0, 0, r_lo(v)));
+		return 1;
+	case R_RISCV_LO12_S:
+		e_write_int(buf, idx, (w & 0x01FFF07F) + r_encode_S(0, 0, 0, r_lo(v)));
+		return 1;
+	case R_RISCV_PCREL_HI20:
+		if (_r_pcrel->size >= MAX_PCREL)
+			error("Too many pc-relative relocations");
+		_r_pcrel->places[_r_pcrel->size] = p;
+		_r_pcrel->offsets[_r_pcrel->size++] = v - p;
+		e_write_int(buf, idx, (w & 4095) + r_encode_U(0, 0, r_hi(v - p)));
+		return 1;
+	case R_RISCV_PCREL_LO12_I:
+		/* symbol is the label of auipc with the high part */
+		e_write_int(buf, idx, (w & 1048575) + r_encode_I(0, 0, 0, r_lo(r_pcrel_offset(v))));
+		return 1;
+	case R_RISCV_PCREL_LO12_S:
+		e_write_int(buf, idx, (w & 0x01FFF07F) + r_encode_S(0, 0, 0, r_lo(r_pcrel_offset(v))));
+		return 1;
+	case R_RISCV_CALL:
+	case R_RISCV_CALL_PLT:
+		/* auipc and jalr pair */
+		e_write_int(buf, idx, (w & 4095) + r_encode_U(0, 0, r_hi(v - p)));
+		w = e_read_int(buf, idx + 4);
+		e_write_int(buf, idx + 4, (w & 1048575) + r_encode_I(0, 0, 0, r_lo(v - p)));
+		return 1;
+	case R_RISCV_RVC_BRANCH:
+		w = e_read_short(buf, idx);
+		e_write_short(buf, idx, (w & 0xE383) + r_encode_CB(0, r_s0, v - p) - 1);
+		return 1;
+	case R_RISCV_RVC_JUMP:
+		w = e_read_short(buf, idx);
+		e_write_short(buf, idx, (w & 0xE003) + r_encode_CJ(0, v - p) - 1);
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* addend held in place, only words have one as RISC-V objects carry addends in RELA entries */
+int r_elf_addend(char *buf, int idx, int type)
+{
+	if (type == R_RISCV_32)
+		return e_read_int(buf, idx);
+	return 0;
+}
+
 int r_dest_reg(int param_no)
 {
 	return param_no + 10;
 }
 
+/* can data at offset in data section be reached from gp in one instruction, gp of an object file is not known */
+int r_gp_reachable(int ofs)
+{
+	if (_e_relocatable && (_e_placed == NULL))
+		return 0;
+	ofs = e_anchor_distance(ofs);
+	if (ofs >= -2048 && ofs < 2048)
+		return 1;
+	return 0;
+}
+
 int r_get_code_length(il_instr *ii)
 {
 	il_op op = ii->op;
 	function_def *fn;
 	block_def *bd;
+	variable_def *var;
+	int len;
+
+	/* compressed code is measured by generating it, but merged addresses take no space */
+	if (r_compressed() && op != op_get_var_addr)
+		return -1;
 
 	switch (op) {
 	case op_entry_point:
 		fn = find_function(ii->string_param1);
-		return 16 + (fn->num_params << 2);
+		return 16 + ((fn->num_params + fn->cache_regs) << 2);
 	case op_function_call:
 	case op_pointer_call:
 		if (ii->param_no != 0)
@@ -433,21 +754,50 @@ int r_get_code_length(il_instr *ii)
 	case op_greater_eq_than:
 		return 16;
 	case op_syscall:
-		return 20;
+		len = 4;
+		if (ii->int_param2 < 0)
+			len += ii->int_param1 << 2;
+		else if (ii->int_param2 >= 2047)
+			len += 8;
+		else
+			len += 4;
+		if (ii->param_no != 0)
+			len += 4;
+		return len;
 	case op_exit_point:
-		return 16;
+		fn = find_function(ii->string_param1);
+		return 16 + (fn->cache_regs << 2);
+	case op_tail_call:
+		return 16 + (ii->int_param2 << 2);
 	case op_exit:
 		return 12;
+	case op_start:
+		return 16;
 	case op_load_data_address:
-	case op_jz:
-	case op_jnz:
+		return 8;
+	case op_get_var_addr:
+		var = find_global_variable(ii->string_param1);
+		if (var != NULL)
+			if ((var->init >= 0) && r_gp_reachable(var->offset)) {
+				/* merged into following access */
+				if (ii->int_param2)
+					return 0;
+				return 4;
+			}
+		if (var == NULL)
+			if (find_function(ii->string_param1) == NULL)
+				return 4; /* local */
+		return 8;
 	case op_push:
 	case op_pop:
-	case op_get_var_addr:
-	case op_start:
 		return 8;
+	case op_jz:
+	case op_jnz:
+		/* shortest form, grown by branch relaxation */
+		return 4;
 	case op_jump:
 	case op_return:
+	case op_move:
 	case op_generic:
 	case op_add:
 	case op_sub:
@@ -471,6 +821,16 @@ int r_get_code_length(il_instr *ii)
 	return 0;
 }
 
+/* absolute address of object file symbol, filled in by the linker */
+void r_load_symbol(backend_state *state)
+{
+	c_reloc(state, R_RISCV_HI20, 0);
+	c_emit(r_lui(state->dest_reg, 0));
+	c_reloc(state, R_RISCV_LO12_I, 0);
+	c_emit(r_addi(state->dest_reg, state->dest_reg, 0));
+}
+
+/* literals are in the same section as code, from pc */
 void r_op_load_data_address(backend_state *state, int ofs)
 {
 	ofs -= state->pc;
@@ -480,16 +840,36 @@ void r_op_load_data_address(backend_state *state, int ofs)
 
 void r_op_load_numeric_constant(backend_state *state, int val)
 {
-	if (val > -2048 && val < 2047) {
-		c_emit(r_addi(state->dest_reg, r_zero, r_lo(val)));
-	} else {
+	if (state->dest_reg == r_gp) {
+		/* data address, unknown while code length is measured */
+		c_reloc(state, R_RISCV_HI20, 0);
 		c_emit(r_lui(state->dest_reg, r_hi(val)));
+		c_reloc(state, R_RISCV_LO12_I, 0);
 		c_emit(r_addi(state->dest_reg, state->dest_reg, r_lo(val)));
+	} else if (val > -2048 && val < 2047) {
+		r_emit(r_addi(state->dest_reg, r_zero, r_lo(val)));
+	} else {
+		r_emit(r_lui(state->dest_reg, r_hi(val)));
+		r_emit(r_addi(state->dest_reg, state->dest_reg, r_lo(val)));
 	}
 }
 
 void r_op_get_global_addr(backend_state *state, int ofs)
 {
+	/* variable of another object */
+	if (state->reloc_symbol >= E_SYM_LOCALS) {
+		r_load_symbol(state);
+		return;
+	}
+	if (r_gp_reachable(ofs - state->data_start)) {
+		r_emit(r_addi(state->dest_reg, r_gp, e_anchor_distance(ofs - state->data_start)));
+		return;
+	}
+	if (state->reloc_symbol != 0) {
+		r_load_symbol(state);
+		return;
+	}
+
 	/* need to find the variable offset in data section, from PC */
 	ofs -= state->pc;
 	c_emit(r_auipc(state->dest_reg, r_hi(ofs)));
@@ -498,13 +878,14 @@ void r_op_get_global_addr(backend_state *state, int ofs)
 
 void r_op_get_local_addr(backend_state *state, int offset)
 {
-	c_emit(r_addi(state->dest_reg, r_s0, 0));
-	c_emit(r_addi(state->dest_reg, state->dest_reg, offset));
+	r_emit(r_addi(state->dest_reg, r_s0, offset));
 }
 
 void r_op_get_function_addr(backend_state *state, int ofs)
 {
+	c_reloc(state, R_RISCV_HI20, 0);
 	c_emit(r_lui(state->dest_reg, r_hi(ofs)));
+	c_reloc(state, R_RISCV_LO12_I, 0);
 	c_emit(r_addi(state->dest_reg, state->dest_reg, r_lo(ofs)));
 }
 
@@ -512,10 +893,10 @@ void r_op_read_addr(backend_state *state, int len)
 {
 	switch (len) {
 	case 4:
-		c_emit(r_lw(state->dest_reg, state->op_reg, 0));
+		r_emit(r_lw(state->dest_reg, state->op_reg, 0));
 		break;
 	case 1:
-		c_emit(r_lb(state->dest_reg, state->op_reg, 0));
+		r_emit(r_lb(state->dest_reg, state->op_reg, 0));
 		break;
 	default:
 		error("Unsupported word size");
@@ -526,74 +907,156 @@ void r_op_write_addr(backend_state *state, int len)
 {
 	switch (len) {
 	case 4:
-		c_emit(r_sw(state->dest_reg, state->op_reg, 0));
+		r_emit(r_sw(state->dest_reg, state->op_reg, 0));
 		break;
 	case 1:
-		c_emit(r_sb(state->dest_reg, state->op_reg, 0));
+		r_emit(r_sb(state->dest_reg, state->op_reg, 0));
 		break;
 	default:
 		error("Unsupported word size");
 	}
 }
 
+void r_op_read_global(backend_state *state, int ofs, int len)
+{
+	ofs = e_anchor_distance(ofs - state->data_start);
+	switch (len) {
+	case 4:
+		r_emit(r_lw(state->dest_reg, r_gp, ofs));
+		break;
+	case 1:
+		r_emit(r_lb(state->dest_reg, r_gp, ofs));
+		break;
+	default:
+		error("Unsupported word size");
+	}
+}
+
+void r_op_write_global(backend_state *state, int ofs, int len)
+{
+	ofs = e_anchor_distance(ofs - state->data_start);
+	switch (len) {
+	case 4:
+		r_emit(r_sw(state->dest_reg, r_gp, ofs));
+		break;
+	case 1:
+		r_emit(r_sb(state->dest_reg, r_gp, ofs));
+		break;
+	default:
+		error("Unsupported word size");
+	}
+}
+
+/* targets beyond the 1MB jal reaches either way */
+int r_far(int ofs)
+{
+	if (ofs >= -1048576 && ofs < 1048576)
+		return 0;
+	return 1;
+}
+
+/* jumps to pc + ofs linking into rd, far targets are reached by auipc into tmp and jalr */
+void r_jump(r_reg rd, r_reg tmp, int ofs)
+{
+	if (r_far(ofs) == 0) {
+		r_emit(r_jal(rd, ofs));
+		return;
+	}
+	c_emit(r_auipc(tmp, r_hi(ofs)));
+	c_emit(r_jalr(rd, tmp, r_lo(ofs)));
+}
+
 void r_op_jump(int ofs)
 {
-	c_emit(r_jal(r_zero, ofs));
+	r_jump(r_zero, r_t0, ofs);
 }
 
 void r_op_return(int ofs)
 {
-	c_emit(r_jal(r_zero, ofs));
+	r_jump(r_zero, r_t0, ofs);
 }
 
 void r_op_function_call(backend_state *state, int ofs)
 {
-	c_emit(r_jal(r_ra, ofs));
+	if (state->reloc_symbol != 0) {
+		/* callee in another object may be anywhere */
+		c_reloc(state, R_RISCV_CALL, 0);
+		c_emit(r_auipc(r_ra, 0));
+		c_emit(r_jalr(r_ra, r_ra, 0));
+	} else
+		r_jump(r_ra, r_ra, ofs);
 	if (state->dest_reg != r_a0)
-		c_emit(r_addi(state->dest_reg, r_a0, 0));
+		r_emit(r_addi(state->dest_reg, r_a0, 0));
+}
+
+/* drops current frame, restoring caller's ra and s0 */
+void r_leave_frame()
+{
+	if (r_compressed()) {
+		/* sp-relative forms have 16-bit encodings */
+		r_emit(r_addi(r_sp, r_s0, 0));
+		r_emit(r_lw(r_ra, r_sp, 8));
+		r_emit(r_lw(r_s0, r_sp, 12));
+		r_emit(r_addi(r_sp, r_sp, 16));
+	} else {
+		r_emit(r_addi(r_sp, r_s0, 16));
+		r_emit(r_lw(r_ra, r_sp, -8));
+		r_emit(r_lw(r_s0, r_sp, -4));
+	}
+}
+
+void r_op_tail_call(int ofs)
+{
+	int pc = _e_code_idx;
+
+	r_leave_frame();
+	r_jump(r_zero, r_t0, ofs - (_e_code_idx - pc));
 }
 
 void r_op_pointer_call(backend_state *state)
 {
-	c_emit(r_jalr(r_ra, state->op_reg, 0));
+	r_emit(r_jalr(r_ra, state->op_reg, 0));
 	if (state->dest_reg != r_a0)
-		c_emit(r_addi(state->dest_reg, r_a0, 0));
+		r_emit(r_addi(state->dest_reg, r_a0, 0));
+}
+
+void r_op_move(backend_state *state)
+{
+	r_emit(r_addi(state->dest_reg, state->op_reg, 0));
 }
 
 void r_op_push(backend_state *state)
 {
-	c_emit(r_addi(r_sp, r_sp, -16)); /* 16 aligned although we only need 4 */
-	c_emit(r_sw(state->dest_reg, r_sp, 0));
+	r_emit(r_addi(r_sp, r_sp, -16)); /* 16 aligned although we only need 4 */
+	r_emit(r_sw(state->dest_reg, r_sp, 0));
 }
 
 void r_op_pop(backend_state *state)
 {
-	c_emit(r_lw(state->dest_reg, r_sp, 0));
-	c_emit(r_addi(r_sp, r_sp, 16)); /* 16 aligned although we only need 4 */
+	r_emit(r_lw(state->dest_reg, r_sp, 0));
+	r_emit(r_addi(r_sp, r_sp, 16)); /* 16 aligned although we only need 4 */
 }
 
 void r_op_exit_point()
 {
-	c_emit(r_addi(r_sp, r_s0, 16));
-	c_emit(r_lw(r_ra, r_sp, -8));
-	c_emit(r_lw(r_s0, r_sp, -4));
-	c_emit(r_jalr(r_zero, r_ra, 0));
+	r_leave_frame();
+	r_emit(r_jalr(r_zero, r_ra, 0));
 }
 
 void r_op_alu(backend_state *state, il_op op)
 {
 	switch (op) {
 	case op_add:
-		c_emit(r_add(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_add(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_sub:
-		c_emit(r_sub(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_sub(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_mul:
-		c_emit(r_mul(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_mul(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_negate:
-		c_emit(r_sub(state->dest_reg, r_zero, state->dest_reg));
+		r_emit(r_sub(state->dest_reg, r_zero, state->dest_reg));
 		break;
 	default:
 		break;
@@ -602,32 +1065,35 @@ void r_op_alu(backend_state *state, il_op op)
 
 void r_op_cmp(backend_state *state, il_op op)
 {
+	int set0 = r_addi(state->dest_reg, r_zero, 0), set1 = r_addi(state->dest_reg, r_zero, 1);
+	int ofs = 8 + r_size(set0); /* skip clearing and jump */
+
 	switch (op) {
 	case op_equals:
-		c_emit(r_beq(state->dest_reg, state->op_reg, 12));
+		c_emit(r_beq(state->dest_reg, state->op_reg, ofs));
 		break;
 	case op_not_equals:
-		c_emit(r_bne(state->dest_reg, state->op_reg, 12));
+		c_emit(r_bne(state->dest_reg, state->op_reg, ofs));
 		break;
 	case op_less_than:
-		c_emit(r_blt(state->dest_reg, state->op_reg, 12));
+		c_emit(r_blt(state->dest_reg, state->op_reg, ofs));
 		break;
 	case op_greater_eq_than:
-		c_emit(r_bge(state->dest_reg, state->op_reg, 12));
+		c_emit(r_bge(state->dest_reg, state->op_reg, ofs));
 		break;
 	case op_greater_than:
-		c_emit(r_blt(state->op_reg, state->dest_reg, 12));
+		c_emit(r_blt(state->op_reg, state->dest_reg, ofs));
 		break;
 	case op_less_eq_than:
-		c_emit(r_bge(state->op_reg, state->dest_reg, 12));
+		c_emit(r_bge(state->op_reg, state->dest_reg, ofs));
 		break;
 	default:
 		error("Unsupported conditional IL op");
 		break;
 	}
-	c_emit(r_addi(state->dest_reg, r_zero, 0));
-	c_emit(r_jal(r_zero, 8));
-	c_emit(r_addi(state->dest_reg, r_zero, 1));
+	r_emit(set0);
+	c_emit(r_jal(r_zero, 4 + r_size(set1)));
+	r_emit(set1);
 }
 
 void r_op_log(backend_state *state, il_op op)
@@ -635,10 +1101,10 @@ void r_op_log(backend_state *state, il_op op)
 	switch (op) {
 	case op_log_and:
 		/* we assume both have to be 1, they can't be just nonzero */
-		c_emit(r_and(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_and(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_log_or:
-		c_emit(r_or(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_or(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	default:
 		break;
@@ -649,97 +1115,129 @@ void r_op_bit(backend_state *state, il_op op)
 {
 	switch (op) {
 	case op_bit_and:
-		c_emit(r_and(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_and(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_bit_or:
-		c_emit(r_or(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_or(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_bit_lshift:
-		c_emit(r_sll(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_sll(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_bit_rshift:
-		c_emit(r_srl(state->dest_reg, state->dest_reg, state->op_reg));
+		r_emit(r_srl(state->dest_reg, state->dest_reg, state->op_reg));
 		break;
 	case op_not:
 		/* only works for small range integers */
-		c_emit(r_sltiu(state->dest_reg, state->dest_reg, 1));
+		r_emit(r_sltiu(state->dest_reg, state->dest_reg, 1));
 		break;
 	default:
 		break;
 	}
 }
 
+/* conditional branch taken on zero (beq) or nonzero (bne) */
+int r_branch_zero(int zero, r_reg rs, int ofs)
+{
+	if (zero)
+		return r_beq(rs, r_zero, ofs);
+	return r_bne(rs, r_zero, ofs);
+}
+
 void r_op_jz(backend_state *state, il_op op, int ofs)
 {
+	int zero = 0, skip, len = 4;
+
+	if (op == op_jz)
+		zero = 1;
+
+	/* offset is given from 4 bytes in, the branch is first here */
+	ofs += 4;
 	if (ofs >= -4096 && ofs <= 4095) {
-		/* near jump (branch) */
-		if (op == op_jz) {
-			c_emit(r_nop());
-			c_emit(r_beq(state->dest_reg, r_zero, ofs));
-		} else if (op == op_jnz) {
-			c_emit(r_nop());
-			c_emit(r_bne(state->dest_reg, r_zero, ofs));
-		}
-	} else {
-		/* far jump */
-		if (op == op_jz) {
-			c_emit(r_bne(state->dest_reg, r_zero, 8)); /* skip next instruction */
-			c_emit(r_jal(r_zero, ofs));
-		} else if (op == op_jnz) {
-			c_emit(r_beq(state->dest_reg, r_zero, 8));
-			c_emit(r_jal(r_zero, ofs));
-		}
+		r_emit(r_branch_zero(zero, state->dest_reg, ofs));
+		return;
 	}
+
+	/* far target, inverted branch skips over a jump */
+	skip = r_size(r_branch_zero(1 - zero, state->dest_reg, 0));
+	if (r_far(ofs - skip))
+		len = 8;
+	r_emit(r_branch_zero(1 - zero, state->dest_reg, skip + len));
+	r_jump(r_zero, r_t0, ofs - skip);
 }
 
 void r_op_block(int len)
 {
-	c_emit(r_addi(r_sp, r_sp, len));
+	r_emit(r_addi(r_sp, r_sp, len));
 }
 
 void r_op_entry_point(int len)
 {
-	c_emit(r_addi(r_sp, r_sp, -16 - len));
-	c_emit(r_sw(r_s0, r_sp, 12 + len));
-	c_emit(r_sw(r_ra, r_sp, 8 + len));
-	c_emit(r_addi(r_s0, r_sp, len));
+	r_emit(r_addi(r_sp, r_sp, -16 - len));
+	r_emit(r_sw(r_s0, r_sp, 12 + len));
+	r_emit(r_sw(r_ra, r_sp, 8 + len));
+	r_emit(r_addi(r_s0, r_sp, len));
 }
 
 void r_op_store_param(int pn, int ofs)
 {
-	c_emit(r_sw(r_a0 + pn, r_s0, ofs));
+	r_emit(r_sw(r_a0 + pn, r_s0, ofs));
+}
+
+void r_op_load_param(int pn, int ofs)
+{
+	r_emit(r_lw(r_a0 + pn, r_s0, ofs));
 }
 
 void r_op_start()
 {
-	c_emit(r_lw(r_a0, r_sp, 0)); /* argc */
-	c_emit(r_addi(r_a1, r_sp, 4)); /* argv */
+	r_emit(r_lw(r_a0, r_sp, 0)); /* argc */
+	r_emit(r_addi(r_a1, r_sp, 4)); /* argv */
 }
 
-void r_op_syscall()
+/* number goes in a7 and arguments from a0, result comes back in a0 */
+void r_op_syscall(backend_state *state, int number, int args)
 {
-	c_emit(r_addi(r_a7, r_a0, 0));
-	c_emit(r_addi(r_a0, r_a1, 0));
-	c_emit(r_addi(r_a1, r_a2, 0));
-	c_emit(r_addi(r_a2, r_a3, 0));
+	int i, rd = state->dest_reg;
+
+	if (number < 0) {
+		/* computed number is in a0, arguments after it */
+		r_emit(r_addi(r_a7, r_a0, 0));
+		for (i = 1; i < args; i++)
+			r_emit(r_addi(r_a0 + i - 1, r_a0 + i, 0));
+	} else {
+		state->dest_reg = r_a7;
+		r_op_load_numeric_constant(state, number);
+		state->dest_reg = rd;
+	}
 	c_emit(r_ecall());
+	if (rd != r_a0)
+		r_emit(r_addi(rd, r_a0, 0));
 }
 
 void r_op_exit()
 {
-	c_emit(r_addi(r_a0, r_zero, 0));
-	c_emit(r_addi(r_a7, r_zero, 93));
+	r_emit(r_addi(r_a0, r_zero, 0));
+	r_emit(r_addi(r_a7, r_zero, 93));
 	c_emit(r_ecall());
 }
 
 void r_initialize_backend(backend_def *be)
 {
+	_r_pcrel = malloc(sizeof(r_pcrel_def));
+	_r_pcrel->size = 0;
 	be->arch = a_riscv;
 	be->source_define = "__RISCV";
+	be->cache_regs = 10; /* s2-s11 */
+	be->first_saved_param = MAX_PARAMS; /* a0-a7 are caller-saved */
+	be->global_reg = r_gp;
 	be->elf_machine = r_elf_machine;
 	be->elf_flags = r_elf_flags;
+	be->elf_word_reloc = R_RISCV_32;
+	be->elf_relocate = r_elf_relocate;
+	be->elf_addend = r_elf_addend;
 	be->c_dest_reg = r_dest_reg;
 	be->c_get_code_length = r_get_code_length;
+	be->c_get_latency = r_get_latency;
 	be->op_load_data_address = r_op_load_data_address;
 	be->op_load_numeric_constant = r_op_load_numeric_constant;
 	be->op_get_global_addr = r_op_get_global_addr;
@@ -747,13 +1245,18 @@ void r_initialize_backend(backend_def *be)
 	be->op_get_function_addr = r_op_get_function_addr;
 	be->op_read_addr = r_op_read_addr;
 	be->op_write_addr = r_op_write_addr;
+	be->op_read_global = r_op_read_global;
+	be->op_write_global = r_op_write_global;
 	be->op_jump = r_op_jump;
 	be->op_return = r_op_return;
 	be->op_function_call = r_op_function_call;
 	be->op_pointer_call = r_op_pointer_call;
+	be->op_tail_call = r_op_tail_call;
+	be->op_move = r_op_move;
 	be->op_push = r_op_push;
 	be->op_pop = r_op_pop;
 	be->op_exit_point = r_op_exit_point;
+	be->op_literal_pool = NULL; /* constants are built inline */
 	be->op_alu = r_op_alu;
 	be->op_cmp = r_op_cmp;
 	be->op_log = r_op_log;
@@ -762,7 +1265,14 @@ void r_initialize_backend(backend_def *be)
 	be->op_block = r_op_block;
 	be->op_entry_point = r_op_entry_point;
 	be->op_store_param = r_op_store_param;
+	be->op_load_param = r_op_load_param;
 	be->op_start = r_op_start;
 	be->op_syscall = r_op_syscall;
 	be->op_exit = r_op_exit;
 }
+
+void r_initialize_compressed_backend(backend_def *be)
+{
+	r_initialize_backend(be);
+	be->arch = a_riscv_c;
+}
@@ -0,0 +1,736 @@
+/* rvcc C compiler - Thumb-2 ISA encoder */
+
+/* Thumb-2 instructions are built as 16-bit values or as 32-bit values with first halfword on top,
+ * registers and conditions are shared with ARMv7 */
+
+int t_low(a_reg r)
+{
+	if (r < a_r8)
+		return 1;
+	return 0;
+}
+
+/* 32-bit instruction from its two halfwords */
+int t_wide(int hw1, int hw2)
+{
+	return (hw1 << 16) + hw2;
+}
+
+/* 12-bit modified immediate as i:imm3:imm8, -1 if value has none */
+int t_modified_imm(int val)
+{
+	int b = val & 255, h = (val >> 8) & 255, rot = 0, imm = -1;
+
+	if (val >= 0 && val < 256)
+		return val;
+	if (val == (b << 16) + b)
+		return 256 + b;
+	if (val == (h << 24) + (h << 8))
+		return 512 + h;
+	if (val == (b << 24) + (b << 16) + (b << 8) + b)
+		return 768 + b;
+
+	/* 1bcdefgh rotated right by 8-31 bits */
+	while (rot < 31 && imm < 0) {
+		/* rotate left by one bit */
+		val = (val << 1) | ((val >> 31) & 1);
+		rot++;
+		if (rot >= 8 && val >= 128 && val < 256)
+			imm = (rot << 7) + (val & 127);
+	}
+	return imm;
+}
+
+/* 32-bit data processing instruction with modified immediate */
+int t_dp_imm(int hw1, a_reg rd, a_reg rn, int imm)
+{
+	return t_wide(hw1 + a_extract_bits(imm, 11, 11, 10, 10) + rn, a_extract_bits(imm, 8, 10, 12, 14) + (rd << 8) + (imm & 255));
+}
+
+/* 32-bit data processing instruction with plain 12 or 16-bit immediate */
+int t_dp_plain(int hw1, a_reg rd, int imm)
+{
+	return t_wide(hw1 + a_extract_bits(imm, 12, 15, 0, 3) + a_extract_bits(imm, 11, 11, 10, 10),
+		      a_extract_bits(imm, 8, 10, 12, 14) + (rd << 8) + (imm & 255));
+}
+
+/* 32-bit data processing instruction with registers */
+int t_dp_reg(int hw1, a_reg rd, a_reg rn, a_reg rm)
+{
+	return t_wide(hw1 + rn, (rd << 8) + rm);
+}
+
+int t_mov_r(a_reg rd, a_reg rm)
+{
+	return 17920 /* 0x4600 */ + ((rd & 8) << 4) + (rm << 3) + (rd & 7);
+}
+
+int t_movw(a_reg rd, int imm)
+{
+	return t_dp_plain(62016 /* 0xF240 */, rd, imm & 65535);
+}
+
+int t_movt(a_reg rd, int imm)
+{
+	return t_dp_plain(62144 /* 0xF2C0 */, rd, (imm >> 16) & 65535);
+}
+
+/* rd = rn + imm, or rn - (-imm) */
+int t_add_i(a_reg rd, a_reg rn, int imm)
+{
+	int neg = 0;
+
+	if (imm < 0) {
+		neg = 1;
+		imm = -imm;
+	}
+	if (imm > 4095)
+		error("Offset too large");
+
+	if (rd == a_sp && rn == a_sp && (imm & 3) == 0 && imm < 512)
+		return 45056 /* 0xB000 */ + (neg << 7) + (imm >> 2);
+	if (neg == 0 && t_low(rd) && rn == a_sp && (imm & 3) == 0 && imm < 1024)
+		return 43008 /* 0xA800 */ + (rd << 8) + (imm >> 2);
+	if (t_low(rd) && t_low(rn) && imm < 8)
+		return 7168 /* 0x1C00 */ + (neg << 9) + (imm << 6) + (rn << 3) + rd;
+	if (rd == rn && t_low(rd) && imm < 256)
+		return 12288 /* 0x3000 */ + (neg << 11) + (rd << 8) + imm;
+	if (imm == 0)
+		return t_mov_r(rd, rn);
+
+	/* addw, subw */
+	return t_dp_imm(61952 /* 0xF200 */ + (neg * 160), rd, rn, imm);
+}
+
+/* loads and stores of words (size 4) or unsigned bytes (size 1) */
+int t_transfer(int load, int size, a_reg rt, a_reg rn, int ofs)
+{
+	int hw1 = 63488; /* 0xF800, strb */
+
+	if (size == 4)
+		hw1 += 64;
+	if (load)
+		hw1 += 16;
+
+	if (ofs >= 0 && t_low(rt)) {
+		if (rn == a_sp && size == 4 && (ofs & 3) == 0 && ofs < 1024)
+			return 36864 /* 0x9000 */ + (load << 11) + (rt << 8) + (ofs >> 2);
+		if (t_low(rn) && size == 4 && (ofs & 3) == 0 && ofs < 128)
+			return 24576 /* 0x6000 */ + (load << 11) + (ofs << 4) + (rn << 3) + rt;
+		if (t_low(rn) && size == 1 && ofs < 32)
+			return 28672 /* 0x7000 */ + (load << 11) + (ofs << 6) + (rn << 3) + rt;
+	}
+	if (ofs >= 0 && ofs < 4096)
+		return t_wide(hw1 + 128 + rn, (rt << 12) + ofs);
+	if (ofs < 0 && ofs > -256)
+		return t_wide(hw1 + rn, (rt << 12) + 3072 /* 0xC00, P=1 U=0 W=0 */ - ofs);
+	error("Offset too large");
+	return 0;
+}
+
+int t_lw(a_reg rt, a_reg rn, int ofs)
+{
+	return t_transfer(1, 4, rt, rn, ofs);
+}
+
+int t_lb(a_reg rt, a_reg rn, int ofs)
+{
+	return t_transfer(1, 1, rt, rn, ofs);
+}
+
+int t_sw(a_reg rt, a_reg rn, int ofs)
+{
+	return t_transfer(0, 4, rt, rn, ofs);
+}
+
+int t_sb(a_reg rt, a_reg rn, int ofs)
+{
+	return t_transfer(0, 1, rt, rn, ofs);
+}
+
+/* b.w and bl with offset from this instruction */
+int t_branch(int hw2, int ofs)
+{
+	int s = 0, j1, j2;
+
+	ofs -= 4;
+	j1 = a_extract_bits(ofs, 23, 23, 0, 0);
+	j2 = a_extract_bits(ofs, 22, 22, 0, 0);
+	/* J bits are the inverted offset bits xor sign */
+	if (ofs < 0)
+		s = 1;
+	else {
+		j1 = 1 - j1;
+		j2 = 1 - j2;
+	}
+	return t_wide(61440 /* 0xF000 */ + (s << 10) + a_extract_bits(ofs, 12, 21, 0, 9),
+		      hw2 + (j1 << 13) + (j2 << 11) + a_extract_bits(ofs, 1, 11, 0, 10));
+}
+
+int t_b(int ofs)
+{
+	return t_branch(36864 /* 0x9000 */, ofs);
+}
+
+int t_bl(int ofs)
+{
+	return t_branch(53248 /* 0xD000 */, ofs);
+}
+
+/* conditional b.w, reaches 1MB */
+int t_bcond(ar_cond cond, int ofs)
+{
+	int s = 0;
+
+	ofs -= 4;
+	if (ofs < -1048576 || ofs > 1048575)
+		error("Offset too large");
+	if (ofs < 0)
+		s = 1;
+	return t_wide(61440 /* 0xF000 */ + (s << 10) + (cond << 6) + a_extract_bits(ofs, 12, 17, 0, 5),
+		      32768 /* 0x8000 */ + a_extract_bits(ofs, 18, 18, 13, 13) + a_extract_bits(ofs, 19, 19, 11, 11) +
+			      a_extract_bits(ofs, 1, 11, 0, 10));
+}
+
+/* unconditional branch, 16-bit form within 2KB */
+int t_jump(int ofs)
+{
+	if (ofs - 4 >= -2048 && ofs - 4 < 2048)
+		return 57344 /* 0xE000 */ + a_extract_bits(ofs - 4, 1, 11, 0, 10);
+	return t_b(ofs);
+}
+
+/* conditional branch, 16-bit form within 256 bytes */
+int t_jump_cond(ar_cond cond, int ofs)
+{
+	if (ofs - 4 >= -256 && ofs - 4 < 256)
+		return 53248 /* 0xD000 */ + (cond << 8) + a_extract_bits(ofs - 4, 1, 8, 0, 7);
+	return t_bcond(cond, ofs);
+}
+
+/* if-then-else block, first instruction runs if cond holds, second if not */
+int t_ite(ar_cond cond)
+{
+	return 48896 /* 0xBF00 */ + (cond << 4) + ((1 - (cond & 1)) << 3) + 4;
+}
+
+int t_cmp_r(a_reg rn, a_reg rm)
+{
+	if (t_low(rn) && t_low(rm))
+		return 17024 /* 0x4280 */ + (rm << 3) + rn;
+	return 17664 /* 0x4500 */ + ((rn & 8) << 4) + (rm << 3) + (rn & 7);
+}
+
+int t_cmp_zero(a_reg rn)
+{
+	if (t_low(rn))
+		return 10240 /* 0x2800 */ + (rn << 8);
+	return t_dp_imm(61872 /* 0xF1B0 */, a_pc, rn, 0);
+}
+
+/* two operand data processing, rd = rd op rm, 16-bit form if registers are low */
+int t_alu(int narrow, int hw1, a_reg rd, a_reg rm)
+{
+	if (t_low(rd) && t_low(rm))
+		return narrow + (rm << 3) + rd;
+	return t_dp_reg(hw1, rd, rd, rm);
+}
+
+int t_add_r(a_reg rd, a_reg rm)
+{
+	return 17408 /* 0x4400 */ + ((rd & 8) << 4) + (rm << 3) + (rd & 7);
+}
+
+int t_sub_r(a_reg rd, a_reg rm)
+{
+	if (t_low(rd) && t_low(rm))
+		return 6656 /* 0x1A00 */ + (rm << 6) + (rd << 3) + rd;
+	return t_dp_reg(60320 /* 0xEBA0 */, rd, rd, rm);
+}
+
+/* multiplies and register shifts, wide form has ones in top of second halfword */
+int t_shift(int narrow, int hw1, a_reg rd, a_reg rm)
+{
+	if (t_low(rd) && t_low(rm))
+		return narrow + (rm << 3) + rd;
+	return t_dp_reg(hw1, rd, rd, rm) + 61440 /* 0xF000 */;
+}
+
+int t_mul(a_reg rd, a_reg rm)
+{
+	return t_shift(17216 /* 0x4340, muls */, 64256 /* 0xFB00 */, rd, rm);
+}
+
+int t_and_r(a_reg rd, a_reg rm)
+{
+	return t_alu(16384 /* 0x4000 */, 59904 /* 0xEA00 */, rd, rm);
+}
+
+int t_or_r(a_reg rd, a_reg rm)
+{
+	return t_alu(17152 /* 0x4300 */, 59968 /* 0xEA40 */, rd, rm);
+}
+
+int t_sll(a_reg rd, a_reg rm)
+{
+	return t_shift(16512 /* 0x4080 */, 64000 /* 0xFA00 */, rd, rm);
+}
+
+int t_srl(a_reg rd, a_reg rm)
+{
+	return t_shift(16576 /* 0x40C0 */, 64032 /* 0xFA20 */, rd, rm);
+}
+
+/* rd = imm - rn */
+int t_rsb_i(a_reg rd, int imm, a_reg rn)
+{
+	if (imm == 0 && t_low(rd) && t_low(rn))
+		return 16960 /* 0x4240 */ + (rn << 3) + rd;
+	return t_dp_imm(61888 /* 0xF1C0 */, rd, rn, t_modified_imm(imm));
+}
+
+int t_elf_machine()
+{
+	return 0x28;
+}
+
+int t_elf_flags()
+{
+	return 0x5000200;
+}
+
+/* patches instruction at idx in buf to refer to value v from place p, halfwords of 32-bit instructions are in memory
+ * order when read as a word, 0 if type is not supported */
+int t_elf_relocate(char *buf, int idx, int type, int v, int p)
+{
+	int w = e_read_int(buf, idx);
+	int rd = (w >> 24) & 15;
+
+	switch (type) {
+	case R_ARM_THM_CALL:
+		/* blx into ARM code, from the word aligned pc */
+		if ((v & 1) == 0)
+			w = t_branch(49152 /* 0xC000 */, v - (p & (0 - 4)) + 4);
+		else
+			w = t_bl(v - p + 4);
+		break;
+	case R_ARM_THM_JUMP24:
+		if ((v & 1) == 0)
+			error("Branch into ARM code");
+		w = t_b(v - p + 4);
+		break;
+	case R_ARM_THM_MOVW_ABS_NC:
+		w = t_movw(rd, v);
+		break;
+	case R_ARM_THM_MOVT_ABS:
+		w = t_movt(rd, v);
+		break;
+	default:
+		return a_elf_relocate(buf, idx, type, v, p);
+	}
+	e_write_int(buf, idx, (w << 16) + ((w >> 16) & 65535));
+	return 1;
+}
+
+/* addend held by 32-bit Thumb instruction in place, its halfwords are stored in order */
+int t_elf_addend(char *buf, int idx, int type)
+{
+	int hw1 = e_read_short(buf, idx), hw2 = e_read_short(buf, idx + 2);
+	int s = (hw1 >> 10) & 1;
+	int i1 = 1 - ((((hw2 >> 13) & 1) + s) & 1);
+	int i2 = 1 - ((((hw2 >> 11) & 1) + s) & 1);
+
+	switch (type) {
+	case R_ARM_THM_CALL:
+	case R_ARM_THM_JUMP24:
+		return a_sign_extend((s << 24) + (i1 << 23) + (i2 << 22) + ((hw1 & 1023) << 12) + ((hw2 & 2047) << 1), 25);
+	case R_ARM_THM_MOVW_ABS_NC:
+	case R_ARM_THM_MOVT_ABS:
+		return a_sign_extend(((hw1 & 15) << 12) + (s << 11) + (((hw2 >> 12) & 7) << 8) + (hw2 & 255), 16);
+	default:
+		return a_elf_addend(buf, idx, type);
+	}
+}
+
+int t_dest_reg(int param_no)
+{
+	return param_no;
+}
+
+/* Thumb-2 mixes 16 and 32-bit instructions, code is sized by generating it */
+int t_get_code_length(il_instr *ii)
+{
+	if (ii->op == op_label)
+		return 0;
+	return -1;
+}
+
+/* emits 16 or 32-bit instruction */
+void t_emit(int instr)
+{
+	int hw1 = (instr >> 16) & 65535;
+
+	if (hw1 != 0)
+		c_emit_short(hw1);
+	c_emit_short(instr & 65535);
+}
+
+/* absolute 32-bit value built by movw and movt, relocated if it refers to a symbol of an object file */
+void t_load_address(backend_state *state, int val)
+{
+	c_reloc(state, R_ARM_THM_MOVW_ABS_NC, 0);
+	t_emit(t_movw(state->dest_reg, val));
+	c_reloc(state, R_ARM_THM_MOVT_ABS, 0);
+	t_emit(t_movt(state->dest_reg, val));
+}
+
+void t_op_load_data_address(backend_state *state, int ofs)
+{
+	t_load_address(state, state->code_start + ofs);
+}
+
+void t_op_load_numeric_constant(backend_state *state, int val)
+{
+	int rd = state->dest_reg;
+
+	if (t_low(rd) && val >= 0 && val < 256)
+		t_emit(8192 /* 0x2000, movs */ + (rd << 8) + val);
+	else if (t_modified_imm(val) >= 0)
+		t_emit(t_dp_imm(61519 /* 0xF04F, mov.w */, rd, 0, t_modified_imm(val)));
+	else if (t_modified_imm(-val - 1) >= 0)
+		t_emit(t_dp_imm(61551 /* 0xF06F, mvn.w */, rd, 0, t_modified_imm(-val - 1)));
+	else if (val >= 0 && val < 65536)
+		t_emit(t_movw(rd, val));
+	else
+		t_load_address(state, val);
+}
+
+void t_op_get_global_addr(backend_state *state, int ofs)
+{
+	t_load_address(state, state->code_start + ofs);
+}
+
+void t_op_get_local_addr(backend_state *state, int offset)
+{
+	t_emit(t_add_i(state->dest_reg, a_s0, offset));
+}
+
+void t_op_get_function_addr(backend_state *state, int ofs)
+{
+	/* bit 0 keeps Thumb state when called through blx */
+	t_load_address(state, ofs + 1);
+}
+
+void t_op_read_addr(backend_state *state, int len)
+{
+	switch (len) {
+	case 4:
+		t_emit(t_lw(state->dest_reg, state->op_reg, 0));
+		break;
+	case 1:
+		t_emit(t_lb(state->dest_reg, state->op_reg, 0));
+		break;
+	default:
+		error("Unsupported word size");
+	}
+}
+
+void t_op_write_addr(backend_state *state, int len)
+{
+	switch (len) {
+	case 4:
+		t_emit(t_sw(state->dest_reg, state->op_reg, 0));
+		break;
+	case 1:
+		t_emit(t_sb(state->dest_reg, state->op_reg, 0));
+		break;
+	default:
+		error("Unsupported word size");
+	}
+}
+
+void t_op_jump(int ofs)
+{
+	t_emit(t_jump(ofs));
+}
+
+void t_op_return(int ofs)
+{
+	t_emit(t_jump(ofs));
+}
+
+void t_op_function_call(backend_state *state, int ofs)
+{
+	if (state->function == NULL) {
+		/* __start runs in ARM state, blx switches to Thumb */
+		c_reloc(state, R_ARM_CALL, -8);
+		c_emit(a_encode(15, 160 + ((ofs & 2) << 3), 0, 0, 0) + (((ofs - 8) >> 2) & 16777215));
+		return;
+	}
+	c_reloc(state, R_ARM_THM_CALL, -4);
+	t_emit(t_bl(ofs));
+	if (state->dest_reg != a_r0)
+		t_emit(t_mov_r(state->dest_reg, a_r0));
+}
+
+/* drops current frame, restoring caller's s0 and lr */
+void t_leave_frame()
+{
+	t_emit(t_mov_r(a_sp, a_s0));
+	t_emit(t_add_i(a_sp, a_sp, 8));
+}
+
+void t_op_tail_call(int ofs)
+{
+	int pc = _e_code_idx;
+
+	t_leave_frame();
+	t_emit(t_wide(59581 /* 0xE8BD, pop.w */, 18432 /* 0x4800, {r11, lr} */));
+	t_emit(t_jump(ofs - (_e_code_idx - pc)));
+}
+
+void t_op_pointer_call(backend_state *state)
+{
+	t_emit(18304 /* 0x4780, blx */ + (state->op_reg << 3));
+	if (state->dest_reg != a_r0)
+		t_emit(t_mov_r(state->dest_reg, a_r0));
+}
+
+void t_op_move(backend_state *state)
+{
+	t_emit(t_mov_r(state->dest_reg, state->op_reg));
+}
+
+void t_op_push(backend_state *state)
+{
+	t_emit(t_add_i(a_sp, a_sp, -16)); /* 16 aligned although we only need 4 */
+	t_emit(t_sw(state->dest_reg, a_sp, 0));
+}
+
+void t_op_pop(backend_state *state)
+{
+	t_emit(t_lw(state->dest_reg, a_sp, 0));
+	t_emit(t_add_i(a_sp, a_sp, 16)); /* 16 aligned although we only need 4 */
+}
+
+void t_op_exit_point()
+{
+	/* popping pc returns to ARM or Thumb caller */
+	t_leave_frame();
+	t_emit(t_wide(59581 /* 0xE8BD, pop.w */, 34816 /* 0x8800, {r11, pc} */));
+}
+
+void t_op_alu(backend_state *state, il_op op)
+{
+	switch (op) {
+	case op_add:
+		t_emit(t_add_r(state->dest_reg, state->op_reg));
+		break;
+	case op_sub:
+		t_emit(t_sub_r(state->dest_reg, state->op_reg));
+		break;
+	case op_mul:
+		t_emit(t_mul(state->dest_reg, state->op_reg));
+		break;
+	case op_negate:
+		t_emit(t_rsb_i(state->dest_reg, 0, state->dest_reg));
+		break;
+	default:
+		break;
+	}
+}
+
+void t_op_cmp(backend_state *state, il_op op)
+{
+	ar_cond cond = a_get_cond(op);
+	int rd = state->dest_reg;
+
+	t_emit(t_cmp_r(rd, state->op_reg));
+	t_emit(t_ite(cond));
+	if (t_low(rd)) {
+		/* movs does not set flags within if-then block */
+		t_emit(8192 /* 0x2000 */ + (rd << 8) + 1);
+		t_emit(8192 /* 0x2000 */ + (rd << 8));
+	} else {
+		t_emit(t_dp_imm(61519 /* 0xF04F */, rd, 0, 1));
+		t_emit(t_dp_imm(61519 /* 0xF04F */, rd, 0, 0));
+	}
+}
+
+void t_op_log(backend_state *state, il_op op)
+{
+	switch (op) {
+	case op_log_and:
+		/* we assume both have to be 1, they can't be just nonzero */
+		t_emit(t_and_r(state->dest_reg, state->op_reg));
+		break;
+	case op_log_or:
+		t_emit(t_or_r(state->dest_reg, state->op_reg));
+		break;
+	default:
+		break;
+	}
+}
+
+void t_op_bit(backend_state *state, il_op op)
+{
+	switch (op) {
+	case op_bit_and:
+		t_emit(t_and_r(state->dest_reg, state->op_reg));
+		break;
+	case op_bit_or:
+		t_emit(t_or_r(state->dest_reg, state->op_reg));
+		break;
+	case op_bit_lshift:
+		t_emit(t_sll(state->dest_reg, state->op_reg));
+		break;
+	case op_bit_rshift:
+		t_emit(t_srl(state->dest_reg, state->op_reg));
+		break;
+	case op_not:
+		/* only works for 1/0 */
+		t_emit(t_rsb_i(state->dest_reg, 1, state->dest_reg));
+		break;
+	default:
+		break;
+	}
+}
+
+void t_op_jz(backend_state *state, il_op op, int ofs)
+{
+	int rd = state->dest_reg, nz = 0, cond = ac_eq, inverse = ac_ne, pc = _e_code_idx;
+
+	if (op == op_jnz) {
+		nz = 1;
+		cond = ac_ne;
+		inverse = ac_eq;
+	}
+
+	/* offset is given from 4 bytes in, where branch would follow an ARM test */
+	ofs += 4;
+
+	/* branch to next instruction, cbz cannot encode it */
+	if (ofs == 2) {
+		t_emit(48896 /* 0xBF00, nop */);
+		return;
+	}
+
+	/* cbz and cbnz test and branch up to 130 bytes forward */
+	if (t_low(rd) && ofs >= 4 && ofs <= 130) {
+		t_emit(45312 /* 0xB100 */ + (nz << 11) + a_extract_bits(ofs - 4, 6, 6, 9, 9) + a_extract_bits(ofs - 4, 1, 5, 3, 7) + rd);
+		return;
+	}
+
+	t_emit(t_cmp_zero(rd));
+	ofs -= _e_code_idx - pc;
+	if (ofs - 4 >= -1048576 && ofs - 4 < 1048576) {
+		t_emit(t_jump_cond(cond, ofs));
+		return;
+	}
+
+	/* far target, inverted branch skips over b.w */
+	t_emit(t_jump_cond(inverse, 6));
+	t_emit(t_b(ofs - 2));
+}
+
+void t_op_block(int len)
+{
+	t_emit(t_add_i(a_sp, a_sp, len));
+}
+
+void t_op_entry_point(int len)
+{
+	t_emit(t_wide(59693 /* 0xE92D, push.w */, 18432 /* 0x4800, {r11, lr} */));
+	t_emit(t_add_i(a_sp, a_sp, -8 - len));
+	t_emit(t_add_i(a_s0, a_sp, len));
+}
+
+/* parameters below s0 further than a negative offset reaches are addressed through r12 */
+void t_op_store_param(int pn, int ofs)
+{
+	if (ofs > -256) {
+		t_emit(t_sw(a_r0 + pn, a_s0, ofs));
+		return;
+	}
+	t_emit(t_add_i(a_r12, a_s0, ofs));
+	t_emit(t_sw(a_r0 + pn, a_r12, 0));
+}
+
+void t_op_load_param(int pn, int ofs)
+{
+	if (ofs > -256) {
+		t_emit(t_lw(a_r0 + pn, a_s0, ofs));
+		return;
+	}
+	t_emit(t_add_i(a_r12, a_s0, ofs));
+	t_emit(t_lw(a_r0 + pn, a_r12, 0));
+}
+
+/* number goes in r7 and arguments from r0, result comes back in r0 */
+void t_op_syscall(backend_state *state, int number, int args)
+{
+	int i, rd = state->dest_reg;
+
+	if (number < 0) {
+		/* computed number is in r0, arguments after it */
+		t_emit(t_mov_r(a_r7, a_r0));
+		for (i = 1; i < args; i++)
+			t_emit(t_mov_r(a_r0 + i - 1, a_r0 + i));
+	} else {
+		state->dest_reg = a_r7;
+		t_op_load_numeric_constant(state, number);
+		state->dest_reg = rd;
+	}
+	t_emit(57088 /* 0xDF00, svc 0 */);
+	if (rd != a_r0)
+		t_emit(t_mov_r(rd, a_r0));
+}
+
+void t_initialize_backend(backend_def *be)
+{
+	/* __start and exit are ARM code, shared with the ARM backend */
+	be->arch = a_thumb2;
+	be->source_define = "__ARM";
+	be->cache_regs = 3; /* r8-r10 */
+	be->first_saved_param = 4; /* r4-r7 */
+	be->global_reg = 0;
+	be->elf_machine = t_elf_machine;
+	be->elf_flags = t_elf_flags;
+	be->elf_word_reloc = R_ARM_ABS32;
+	be->elf_relocate = t_elf_relocate;
+	be->elf_addend = t_elf_addend;
+	be->c_dest_reg = t_dest_reg;
+	be->c_get_code_length = t_get_code_length;
+	be->c_get_latency = a_get_latency;
+	be->op_load_data_address = t_op_load_data_address;
+	be->op_load_numeric_constant = t_op_load_numeric_constant;
+	be->op_get_global_addr = t_op_get_global_addr;
+	be->op_get_local_addr = t_op_get_local_addr;
+	be->op_get_function_addr = t_op_get_function_addr;
+	be->op_read_addr = t_op_read_addr;
+	be->op_write_addr = t_op_write_addr;
+	be->op_read_global = NULL;
+	be->op_write_global = NULL;
+	be->op_jump = t_op_jump;
+	be->op_return = t_op_return;
+	be->op_function_call = t_op_function_call;
+	be->op_pointer_call = t_op_pointer_call;
+	be->op_tail_call = t_op_tail_call;
+	be->op_move = t_op_move;
+	be->op_push = t_op_push;
+	be->op_pop = t_op_pop;
+	be->op_exit_point = t_op_exit_point;
+	be->op_literal_pool = NULL;
+	be->op_alu = t_op_alu;
+	be->op_cmp = t_op_cmp;
+	be->op_log = t_op_log;
+	be->op_bit = t_op_bit;
+	be->op_jz = t_op_jz;
+	be->op_block = t_op_block;
+	be->op_entry_point = t_op_entry_point;
+	be->op_store_param = t_op_store_param;
+	be->op_load_param = t_op_load_param;
+	be->op_start = a_op_start;
+	be->op_syscall = t_op_syscall;
+	be->op_exit = a_op_exit;
+}
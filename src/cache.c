@@ -0,0 +1,374 @@
+/* rvcc C compiler - compilation cache, an entry holds output and IL listing under a key hashed from all they depend on,
+ * with the source it was compiled from to tell keys that collide apart */
+
+/* hashes bytes into both words of key */
+void k_hash(char *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		_k_key[0] = (_k_key[0] + buf[i]) * 16777619;
+		_k_key[1] = (_k_key[1] + buf[i]) * 1000003;
+	}
+}
+
+void k_hash_int(int val)
+{
+	char buf[4];
+
+	e_write_int(buf, 0, val);
+	k_hash(buf, 4);
+}
+
+/* hashes contents of file, 0 if it has none to read */
+int k_hash_file(char *file)
+{
+	FILE *fp;
+	char buf[1024];
+	int n = 1, total = 0;
+
+	fp = fopen(file, "rb");
+	if (fp == NULL)
+		return 0;
+	while (n > 0) {
+		n = fread(buf, 1, 1024, fp);
+		k_hash(buf, n);
+		total += n;
+	}
+	fclose(fp);
+	return total;
+}
+
+/* file of entry, named by the whole key */
+void k_path(char *path)
+{
+	sprintf(path, "%s/%08x%08x.rvc", _k_dir, _k_key[0], _k_key[1]);
+}
+
+/* file this process writes before it becomes an entry */
+void k_temp_path(char *path, char *suffix)
+{
+	sprintf(path, "%s/%08x%08x.%d%s", _k_dir, _k_key[0], _k_key[1], getpid(), suffix);
+}
+
+/* entries are named by 16 hex digits of their key and .rvc */
+int k_is_entry(char *name)
+{
+	if (strlen(name) != 20)
+		return 0;
+	return strcmp(name + 16, ".rvc") == 0;
+}
+
+/* name of a directory entry, NULL past the last one */
+char *k_entry_name(struct dirent *entry)
+{
+	if (entry == NULL)
+		return NULL;
+	return entry->d_name;
+}
+
+/* number of bytes in file */
+int k_file_size(char *file)
+{
+	FILE *fp;
+	char buf[1024];
+	int n = 1, total = 0;
+
+	fp = fopen(file, "rb");
+	if (fp == NULL)
+		return 0;
+	while (n > 0) {
+		n = fread(buf, 1, 1024, fp);
+		total += n;
+	}
+	fclose(fp);
+	return total;
+}
+
+/* copies up to n bytes from one stream to another */
+void k_copy(FILE *from, FILE *to, int n)
+{
+	char buf[1024];
+	int len = 1;
+
+	while ((n > 0) && (len > 0)) {
+		len = n;
+		if (len > 1024)
+			len = 1024;
+		len = fread(buf, 1, len, from);
+		fwrite(buf, 1, len, to);
+		n -= len;
+	}
+}
+
+/* reads entry header: magic, key, config, source, output and listing sizes, 0 if stream holds no entry */
+int k_read_header(FILE *fp, int *header)
+{
+	char buf[K_HEADER];
+	int i;
+
+	if (fread(buf, 1, K_HEADER, fp) != K_HEADER)
+		return 0;
+	for (i = 0; i < 7; i++)
+		header[i] = e_read_int(buf, i << 2);
+	if (header[0] != K_MAGIC)
+		return 0;
+	return 1;
+}
+
+/* starts caching into dir once all source is loaded, key covers the compiler itself, target, options and source */
+int k_start(char *dir, char *compiler, int config)
+{
+	int i = 0, path = 0;
+
+	if (strlen(dir) > (MAX_PATH_LEN - 48)) {
+		printf("Cache disabled, directory name too long\n");
+		return 0;
+	}
+	while (compiler[i] != 0) {
+		if (compiler[i] == '/')
+			path = 1;
+		i++;
+	}
+	/* a compiler found through PATH is read back through procfs */
+	if (path == 0)
+		compiler = "/proc/self/exe";
+	_k_key[0] = 0;
+	_k_key[1] = 0;
+	if (k_hash_file(compiler) == 0) {
+		printf("Cache disabled, unable to read compiler %s\n", compiler);
+		return 0;
+	}
+	k_hash_int(config);
+	k_hash_int(_source_idx);
+	k_hash(_source, _source_idx);
+	_k_dir = dir;
+	_k_config = config;
+	_k_source_len = _source_idx;
+	return 1;
+}
+
+/* compares source stored in an entry with the one loaded, 1 if they are the same */
+int k_same_source(FILE *fp, int len)
+{
+	char buf[1024];
+	int i = 0, n = 1, same = 1;
+
+	if (len != _k_source_len)
+		return 0;
+	while ((i < len) && (n > 0) && same) {
+		n = len - i;
+		if (n > 1024)
+			n = 1024;
+		n = fread(buf, 1, n, fp);
+		if (memcmp(buf, _source + i, n) != 0)
+			same = 0;
+		i += n;
+	}
+	if (i < len)
+		return 0;
+	return same;
+}
+
+/* writes stored output and echoes stored listing, 0 if the key has no entry */
+int k_fetch(char *outfile)
+{
+	char path[MAX_PATH_LEN];
+	int header[7];
+	int hit = 0;
+	FILE *fp, *out;
+
+	k_path(path);
+	fp = fopen(path, "rb");
+	if (fp == NULL)
+		return 0;
+	if (k_read_header(fp, header))
+		if ((header[1] == _k_key[0]) && (header[2] == _k_key[1]) && (header[3] == _k_config))
+			hit = k_same_source(fp, header[4]);
+	if (hit == 0) {
+		fclose(fp);
+		return 0;
+	}
+	out = fopen(outfile, "wb");
+	if (out == NULL)
+		error("Unable to write output file");
+	k_copy(fp, out, header[5]);
+	fclose(out);
+	k_copy(fp, stdout, header[6]);
+	fclose(fp);
+	/* entry is now the most recently used */
+	utime(path, NULL);
+	printf("Found in cache as %s\n", path);
+	return 1;
+}
+
+/* sends IL listing to a temporary file, to be stored with output */
+void k_start_listing()
+{
+	_k_listing = malloc(MAX_PATH_LEN);
+	k_temp_path(_k_listing, ".lst");
+	_c_listing = fopen(_k_listing, "wb");
+	if (_c_listing == NULL) {
+		_c_listing = stdout;
+		_k_listing = NULL;
+	}
+}
+
+/* echoes listing written so far, once code is generated */
+void k_end_listing()
+{
+	FILE *fp;
+
+	if (_c_listing == stdout)
+		return;
+	fclose(_c_listing);
+	_c_listing = stdout;
+	fp = fopen(_k_listing, "rb");
+	if (fp != NULL) {
+		k_copy(fp, stdout, 2147483647);
+		fclose(fp);
+	}
+}
+
+/* compilation failed, nothing gets stored */
+void k_abandon()
+{
+	if (_k_listing != NULL) {
+		k_end_listing();
+		remove(_k_listing);
+		_k_listing = NULL;
+	}
+}
+
+/* bytes taken by entry in file, 0 if it is gone */
+int k_entry_size(char *path)
+{
+	int header[7], size = 0;
+	FILE *fp;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL)
+		return 0;
+	size = K_HEADER;
+	if (k_read_header(fp, header)) {
+		size += header[4];
+		size += header[5];
+		size += header[6];
+	}
+	fclose(fp);
+	return size;
+}
+
+/* modification time of entry, which a hit sets to its time */
+int k_entry_time(char *path)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0)
+		return 0;
+	return st.st_mtime;
+}
+
+/* path of the entry besides the one of key used longest ago, 0 if there is none */
+int k_oldest_entry(char *oldest)
+{
+	char path[MAX_PATH_LEN], own[MAX_PATH_LEN];
+	DIR *dir;
+	char *name;
+	int found = 0, time, age = 0;
+
+	k_path(own);
+	dir = opendir(_k_dir);
+	if (dir == NULL)
+		return 0;
+	name = k_entry_name(readdir(dir));
+	while (name != NULL) {
+		if (k_is_entry(name)) {
+			sprintf(path, "%s/%s", _k_dir, name);
+			if (strcmp(path, own) != 0) {
+				time = k_entry_time(path);
+				if ((found == 0) || (time < age)) {
+					strcpy(oldest, path);
+					age = time;
+					found = 1;
+				}
+			}
+		}
+		name = k_entry_name(readdir(dir));
+	}
+	closedir(dir);
+	return found;
+}
+
+/* removes entries besides the one of key, least recently used first, until all fit the size limit */
+void k_evict(int incoming)
+{
+	char path[MAX_PATH_LEN], own[MAX_PATH_LEN];
+	DIR *dir;
+	char *name;
+	int total = incoming, found = 1;
+
+	k_path(own);
+	dir = opendir(_k_dir);
+	if (dir == NULL)
+		return;
+	name = k_entry_name(readdir(dir));
+	while (name != NULL) {
+		if (k_is_entry(name)) {
+			sprintf(path, "%s/%s", _k_dir, name);
+			if (strcmp(path, own) != 0)
+				total += k_entry_size(path);
+		}
+		name = k_entry_name(readdir(dir));
+	}
+	closedir(dir);
+
+	while ((total > _k_limit) && found) {
+		found = k_oldest_entry(path);
+		if (found) {
+			total -= k_entry_size(path);
+			remove(path);
+		}
+	}
+}
+
+/* stores source, output and listing as the entry of key, written aside and renamed into place so readers never see part of it */
+void k_store(char *outfile)
+{
+	char tmp[MAX_PATH_LEN], path[MAX_PATH_LEN], buf[K_HEADER];
+	int out_size, listing_size, size;
+	FILE *fp, *in;
+
+	if (_k_listing == NULL)
+		return;
+	out_size = k_file_size(outfile);
+	listing_size = k_file_size(_k_listing);
+	size = ((K_HEADER + _k_source_len) + out_size) + listing_size;
+	k_temp_path(tmp, ".tmp");
+	fp = NULL;
+	if (size <= _k_limit)
+		fp = fopen(tmp, "wb");
+	if (fp != NULL) {
+		e_write_int(buf, 0, K_MAGIC);
+		e_write_int(buf, 4, _k_key[0]);
+		e_write_int(buf, 8, _k_key[1]);
+		e_write_int(buf, 12, _k_config);
+		e_write_int(buf, 16, _k_source_len);
+		e_write_int(buf, 20, out_size);
+		e_write_int(buf, 24, listing_size);
+		fwrite(buf, 1, K_HEADER, fp);
+		fwrite(_source, 1, _k_source_len, fp);
+		in = fopen(outfile, "rb");
+		k_copy(in, fp, out_size);
+		fclose(in);
+		in = fopen(_k_listing, "rb");
+		k_copy(in, fp, listing_size);
+		fclose(in);
+		fclose(fp);
+		k_evict(size);
+		k_path(path);
+		rename(tmp, path);
+	}
+	remove(_k_listing);
+	_k_listing = NULL;
+}
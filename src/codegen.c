@@ -1,17 +1,64 @@
 /* rvcc C compiler - IL->binary code generator */
 
+/* counts parameter registers the function writes that the platform ABI has callee-saved, tail calls restore them too */
+void c_saved_params(function_def *fn)
+{
+	int i, r, top = 0;
+
+	if (fn->entry_point < 0)
+		return;
+	for (i = fn->entry_point; i <= fn->exit_point; i++) {
+		r = _il[i].param_no;
+		if (_il[i].op == op_syscall)
+			r = MAX_PARAMS - 1; /* number register */
+		if (r >= _backend->first_saved_param && r < MAX_PARAMS && r - _backend->first_saved_param + 1 > top)
+			top = r - _backend->first_saved_param + 1;
+	}
+	fn->saved_params = top;
+	for (i = fn->entry_point; i <= fn->exit_point; i++)
+		if (_il[i].op == op_tail_call)
+			_il[i].int_param2 = fn->cache_regs + top; /* registers to restore */
+}
+
+/* stores registers used by the optimizer and saved parameter registers below the parameters */
+void c_save_regs(function_def *fn)
+{
+	int j;
+
+	for (j = 0; j < fn->cache_regs; j++)
+		_backend->op_store_param(MAX_PARAMS + j, -(fn->cache_offset + (j << 2) + 4));
+	for (j = 0; j < fn->saved_params; j++)
+		_backend->op_store_param(_backend->first_saved_param + j, -(fn->cache_offset + ((fn->cache_regs + j) << 2) + 4));
+}
+
+/* reloads what c_save_regs stored */
+void c_restore_regs(function_def *fn)
+{
+	int j;
+
+	for (j = 0; j < fn->cache_regs; j++)
+		_backend->op_load_param(MAX_PARAMS + j, -(fn->cache_offset + (j << 2) + 4));
+	for (j = 0; j < fn->saved_params; j++)
+		_backend->op_load_param(_backend->first_saved_param + j, -(fn->cache_offset + ((fn->cache_regs + j) << 2) + 4));
+}
+
 /* calculates stack space needed for function's parameters */
 void c_size_function(function_def *fn)
 {
 	int s = 0, i;
 
-	/* parameters are turned into local variables */
+	/* parameters are turned into local variables, each stored as a word */
 	for (i = 0; i < fn->num_params; i++) {
-		int vs = size_variable(&fn->param_defs[i]);
+		int vs = align_offset(size_variable(&fn->param_defs[i]), 4);
 		fn->param_defs[i].offset = s + vs; /* set stack offset */
 		s += vs;
 	}
 
+	/* callee-saved registers used by the optimizer, then parameter registers foreign callers expect kept */
+	c_saved_params(fn);
+	fn->cache_offset = s;
+	s += (fn->cache_regs + fn->saved_params) << 2;
+
 	/* align to 16 bytes */
 	if ((s & 15) > 0)
 		s = (s - (s & 15)) + 16;
@@ -35,11 +82,12 @@ int c_size_block(block_def *bd)
 	else
 		offset = c_size_block(bd->parent);
 
-	/* declared locals */
+	/* declared locals, at aligned addresses below the aligned frame */
 	for (i = 0; i < bd->next_local; i++) {
 		int vs = size_variable(&bd->locals[i]);
-		bd->locals[i].offset = size + offset + vs; /* for looking up value off stack */
-		size += vs;
+		int end = align_offset(size + offset + vs, align_variable(&bd->locals[i]));
+		bd->locals[i].offset = end; /* for looking up value off stack */
+		size = end - offset;
 	}
 
 	/* align to 16 bytes */
@@ -52,8 +100,8 @@ int c_size_block(block_def *bd)
 	return size + offset;
 }
 
-/* calculate stack necessary sizes for all functions */
-void c_size_functions(int data_start)
+/* calculate stack necessary sizes for all functions, place globals in data section */
+void c_size_functions()
 {
 	block_def *bd;
 	int i;
@@ -66,319 +114,579 @@ void c_size_functions(int data_start)
 	for (i = 1; i < _blocks_idx; i++)
 		c_size_block(&_blocks[i]);
 
-	/* allocate data for globals, in block 0 */
+	/* allocate data for globals without initializer, in block 0, word aligned after the literals */
+	if ((_e_data_idx & 3) > 0)
+		_e_data_idx = (_e_data_idx - (_e_data_idx & 3)) + 4;
 	bd = &_blocks[0];
-	for (i = 0; i < bd->next_local; i++) {
-		bd->locals[i].offset = _e_data_idx; /* set offset in data section */
-		e_add_symbol(bd->locals[i].variable_name, strlen(bd->locals[i].variable_name),
-			     data_start + _e_data_idx);
-		_e_data_idx += size_variable(&bd->locals[i]);
+	for (i = 0; i < bd->next_local; i++)
+		if (bd->locals[i].init == 0) {
+			_e_data_idx = align_offset(_e_data_idx, align_variable(&bd->locals[i]));
+			bd->locals[i].offset = _e_data_idx; /* set offset in data section */
+			_e_data_idx += size_variable(&bd->locals[i]);
+		}
+}
+
+/* add globals to symbol table once data section address is known */
+void c_add_global_symbols(int data_start)
+{
+	block_def *bd = &_blocks[0];
+	int i;
+
+	for (i = 0; i < bd->next_local; i++)
+		if (bd->locals[i].init >= 0)
+			e_add_symbol(bd->locals[i].variable_name, strlen(bd->locals[i].variable_name),
+				     data_start + bd->locals[i].offset);
+}
+
+/* global accessed by instruction i whose address calculation was left out */
+variable_def *c_folded_global(int i)
+{
+	il_instr *prev;
+
+	if (i == 0)
+		return NULL;
+	prev = &_il[i - 1];
+	if (prev->op != op_get_var_addr || prev->op_len > 0)
+		return NULL;
+	return find_global_variable(prev->string_param1);
+}
+
+/* offset from current instruction to code of IL instruction target, a target not placed yet is taken to closely follow
+ * so that branches start from their shortest encoding */
+int c_branch_offset(backend_state *state, int target)
+{
+	if (_il[target].code_offset < 0)
+		return 4;
+	return _il[target].code_offset - state->pc;
+}
+
+/* emits binary code of IL instruction i */
+void c_generate_instr(backend_state *state, int i)
+{
+	int offset, ofs, val;
+	variable_def *var;
+	function_def *fn;
+
+	block_def *bd = state->block;
+	il_instr *ii = &_il[i];
+	il_op op = ii->op;
+	state->pc = _e_code_idx;
+	state->dest_reg = _backend->c_dest_reg(ii->param_no);
+	state->op_reg = _backend->c_dest_reg(ii->int_param1);
+	state->reloc_symbol = 0;
+	state->reloc_addend = 0;
+
+	switch (op) {
+	case op_load_data_address:
+		/* lookup address of a literal, in code segment after the instructions */
+		ofs = _e_rodata_start + ii->int_param1;
+		e_reloc_rodata(state, ii->int_param1);
+		_backend->op_load_data_address(state, ofs);
+		break;
+	case op_load_numeric_constant:
+		/* load numeric constant */
+		val = ii->int_param1;
+		_backend->op_load_numeric_constant(state, val);
+		break;
+	case op_get_var_addr:
+		/* lookup address of a variable */
+		var = find_global_variable(ii->string_param1);
+		if (var != NULL) {
+			int ofs = state->data_start + var->offset;
+			if (var->init >= 0)
+				e_reloc_data(state, var->offset);
+			else if (_e_relocatable)
+				e_reloc_symbol(state, var->variable_name);
+			else
+				error("Undefined global variable");
+			/* no code if merged into following access */
+			if (ii->op_len != 0)
+				_backend->op_get_global_addr(state, ofs);
+		} else {
+			/* need to find the variable offset on stack, i.e. from s0 */
+			var = find_local_variable(ii->string_param1, bd);
+			if (var != NULL) {
+				offset = -var->offset;
+				_backend->op_get_local_addr(state, offset);
+			} else {
+				/* is it function address? */
+				fn = find_function(ii->string_param1);
+				if (fn != NULL) {
+					ofs = 0;
+					if (fn->entry_point >= 0)
+						ofs = state->code_start + _il[fn->entry_point].code_offset; /* load code offset into variable */
+					else if (_e_relocatable == 0)
+						error("Undefined function");
+					e_reloc_symbol(state, ii->string_param1);
+					_backend->op_get_function_addr(state, ofs);
+				} else
+					error("Undefined identifier");
+			}
+		}
+		break;
+	case op_read_addr:
+		/* read (dereference) memory address */
+		var = c_folded_global(i);
+		if (var != NULL)
+			_backend->op_read_global(state, state->data_start + var->offset, ii->int_param2);
+		else
+			_backend->op_read_addr(state, ii->int_param2);
+		break;
+	case op_write_addr:
+		/* write at memory address */
+		var = c_folded_global(i);
+		if (var != NULL)
+			_backend->op_write_global(state, state->data_start + var->offset, ii->int_param2);
+		else
+			_backend->op_write_addr(state, ii->int_param2);
+		break;
+	case op_jump:
+		/* unconditional jump to an IL-index */
+		ofs = c_branch_offset(state, ii->int_param1);
+		_backend->op_jump(ofs);
+		break;
+	case op_return: {
+		/* jump to function exit */
+		function_def *fd = find_function(ii->string_param1);
+		ofs = c_branch_offset(state, fd->exit_point);
+		_backend->op_return(ofs);
+	} break;
+	case op_function_call:
+		/* function call, to be relocated if it is in another unit */
+		fn = find_function(ii->string_param1);
+		if (fn->entry_point >= 0)
+			ofs = c_branch_offset(state, fn->entry_point);
+		else if (fn->link_offset >= 0)
+			ofs = fn->link_offset - (_e_placed_code + state->pc); /* in clib placed before us */
+		else if (_e_relocatable) {
+			e_reloc_symbol(state, ii->string_param1);
+			ofs = 0;
+		} else
+			error("Undefined function");
+		_backend->op_function_call(state, ofs);
+		break;
+	case op_tail_call:
+		/* restore registers used by the optimizer */
+		c_restore_regs(state->function);
+
+		/* drop our frame and jump, callee returns to our caller */
+		fn = find_function(ii->string_param1);
+		ofs = c_branch_offset(state, fn->entry_point) - (_e_code_idx - state->pc);
+		_backend->op_tail_call(ofs);
+		break;
+	case op_pointer_call:
+		/* function pointer call, address in op_reg, result in dest_reg */
+		_backend->op_pointer_call(state);
+		break;
+	case op_move:
+		_backend->op_move(state);
+		break;
+	case op_push:
+		_backend->op_push(state);
+		break;
+	case op_pop:
+		_backend->op_pop(state);
+		break;
+	case op_exit_point:
+		/* restore registers used by the optimizer */
+		c_restore_regs(find_function(ii->string_param1));
+
+		/* restore previous frame */
+		_backend->op_exit_point();
+		if (_backend->op_literal_pool != NULL)
+			_backend->op_literal_pool(state);
+		break;
+	case op_add:
+	case op_sub:
+	case op_mul:
+	case op_negate:
+		_backend->op_alu(state, op);
+		break;
+	case op_label:
+		if (ii->string_param1 != NULL && state->sizing == 0 && _e_relocatable == 0)
+			/* TODO: lazy eval */
+			if (strlen(ii->string_param1) > 0)
+				e_add_symbol(ii->string_param1, strlen(ii->string_param1), state->code_start + state->pc);
+		break;
+	case op_equals:
+	case op_not_equals:
+	case op_less_than:
+	case op_less_eq_than:
+	case op_greater_than:
+	case op_greater_eq_than:
+		/* we want 1/nonzero if equ, 0 otherwise */
+		_backend->op_cmp(state, op);
+		break;
+	case op_log_and:
+	case op_log_or:
+		_backend->op_log(state, op);
+		break;
+	case op_bit_and:
+	case op_bit_or:
+	case op_bit_lshift:
+	case op_bit_rshift:
+	case op_not:
+		/* op_not gives 1 if zero, 0 if nonzero */
+		_backend->op_bit(state, op);
+		break;
+	case op_jz:
+	case op_jnz: {
+		/* conditional jumps to IL-index, offset is from 4 bytes in where branch follows the test */
+		int ofs = c_branch_offset(state, ii->int_param1) - 4;
+		_backend->op_jz(state, op, ofs);
+	} break;
+	case op_generic:
+		c_emit(ii->int_param1);
+		break;
+	case op_block_start:
+		bd = &_blocks[ii->int_param1];
+		if (bd->next_local > 0)
+			/* reserve stack space for locals */
+			_backend->op_block(-bd->locals_size);
+		break;
+	case op_block_end:
+		bd = &_blocks[ii->int_param1]; /* should not be necessarry */
+		if (bd->next_local > 0)
+			/* remove stack space for locals */
+			_backend->op_block(bd->locals_size);
+		/* bd is current block */
+		bd = bd->parent;
+		break;
+	case op_entry_point: {
+		int pn, ps;
+		fn = find_function(ii->string_param1);
+		ps = fn->params_size;
+		state->function = fn;
+
+		/* add to symbol table, object files list functions once code is placed */
+		if (state->sizing == 0 && _e_relocatable == 0)
+			e_add_symbol(ii->string_param1, strlen(ii->string_param1), state->code_start + state->pc);
+
+		/* create stack space for params and parent frame */
+		_backend->op_entry_point(ps);
+
+		/* push parameters on stack */
+		for (pn = 0; pn < fn->num_params; pn++) {
+			_backend->op_store_param(pn, -fn->param_defs[pn].offset);
+		}
+
+		/* preserve registers used by the optimizer */
+		c_save_regs(fn);
+	} break;
+	case op_start:
+		_backend->op_start();
+		if (_backend->global_reg != 0) {
+			/* point global register into data section */
+			state->dest_reg = _backend->global_reg;
+			e_reloc_symbol(state, "__global_pointer$");
+			_backend->op_load_numeric_constant(state, state->code_start + state->data_start + data_anchor());
+		}
+		break;
+	case op_syscall:
+		/* number and arguments in registers, result in dest_reg */
+		_backend->op_syscall(state, ii->int_param2, ii->int_param1);
+		break;
+	case op_exit:
+		_backend->op_exit();
+		break;
+	default:
+		error("Unsupported IL op");
+	}
+	state->block = bd;
+}
+
+/* prints IL instruction i next to the address of its code */
+void c_log_instr(backend_state *state, int i)
+{
+	int j;
+	function_def *fn;
+
+	il_instr *ii = &_il[i];
+	il_op op = ii->op;
+
+	/* format IL log prefix */
+	fprintf(_c_listing, "%4d %3d  %#010x     ", i, op, state->code_start + state->pc);
+	for (j = 0; j < _c_block_level; j++)
+		fprintf(_c_listing, "  ");
+
+	switch (op) {
+	case op_load_data_address:
+		fprintf(_c_listing, "  x%d := &rodata[%d]", state->dest_reg, ii->int_param1);
+		break;
+	case op_load_numeric_constant:
+		fprintf(_c_listing, "  x%d := %d", state->dest_reg, ii->int_param1);
+		break;
+	case op_get_var_addr:
+		fprintf(_c_listing, "  x%d = &%s", state->dest_reg, ii->string_param1);
+		break;
+	case op_read_addr:
+		fprintf(_c_listing, "  x%d = *x%d (%d)", state->dest_reg, state->op_reg, ii->int_param2);
+		break;
+	case op_write_addr:
+		fprintf(_c_listing, "  *x%d = x%d (%d)", state->op_reg, state->dest_reg, ii->int_param2);
+		break;
+	case op_jump:
+		fprintf(_c_listing, "  -> %d", ii->int_param1);
+		break;
+	case op_return:
+		fprintf(_c_listing, "  return %s", ii->string_param1);
+		break;
+	case op_function_call:
+		fn = find_function(ii->string_param1);
+		fprintf(_c_listing, "  x%d := %s() @ %d", state->dest_reg, ii->string_param1, fn->entry_point);
+		break;
+	case op_tail_call:
+		fn = find_function(ii->string_param1);
+		fprintf(_c_listing, "  x%d := %s() @ %d, tail", state->dest_reg, ii->string_param1, fn->entry_point);
+		break;
+	case op_pointer_call:
+		fprintf(_c_listing, "  x%d := x%d()", state->dest_reg, state->op_reg);
+		break;
+	case op_move:
+		fprintf(_c_listing, "  x%d := x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_push:
+		fprintf(_c_listing, "  push x%d", state->dest_reg);
+		break;
+	case op_pop:
+		fprintf(_c_listing, "  pop x%d", state->dest_reg);
+		break;
+	case op_exit_point:
+		fprintf(_c_listing, "  exit %s", ii->string_param1);
+		break;
+	case op_add:
+		fprintf(_c_listing, "  x%d += x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_sub:
+		fprintf(_c_listing, "  x%d -= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_mul:
+		fprintf(_c_listing, "  x%d *= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_negate:
+		fprintf(_c_listing, "  -x%d", state->dest_reg);
+		break;
+	case op_label:
+		fprintf(_c_listing, " _:");
+		break;
+	case op_equals:
+		fprintf(_c_listing, "  x%d == x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_not_equals:
+		fprintf(_c_listing, "  x%d != x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_less_than:
+		fprintf(_c_listing, "  x%d < x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_greater_eq_than:
+		fprintf(_c_listing, "  x%d >= x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_greater_than:
+		fprintf(_c_listing, "  x%d > x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_less_eq_than:
+		fprintf(_c_listing, "  x%d <= x%d ?", state->dest_reg, state->op_reg);
+		break;
+	case op_log_and:
+		fprintf(_c_listing, "  x%d &&= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_log_or:
+		fprintf(_c_listing, "  x%d ||= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_bit_and:
+		fprintf(_c_listing, "  x%d &= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_bit_or:
+		fprintf(_c_listing, "  x%d |= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_bit_lshift:
+		fprintf(_c_listing, "  x%d <<= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_bit_rshift:
+		fprintf(_c_listing, "  x%d >>= x%d", state->dest_reg, state->op_reg);
+		break;
+	case op_not:
+		fprintf(_c_listing, "  !x%d", state->dest_reg);
+		break;
+	case op_jz:
+		fprintf(_c_listing, "  if 0 -> %d", ii->int_param1);
+		break;
+	case op_jnz:
+		fprintf(_c_listing, "  if 1 -> %d", ii->int_param1);
+		break;
+	case op_generic:
+		fprintf(_c_listing, "  asm %#010x", ii->int_param1);
+		break;
+	case op_block_start:
+		fprintf(_c_listing, "  {");
+		_c_block_level++;
+		break;
+	case op_block_end:
+		fprintf(_c_listing, "}");
+		_c_block_level--;
+		break;
+	case op_entry_point:
+		fprintf(_c_listing, "%s:", ii->string_param1);
+		break;
+	case op_start:
+		fprintf(_c_listing, "  start");
+		break;
+	case op_syscall:
+		fprintf(_c_listing, "  x%d := syscall %d", state->dest_reg, ii->int_param2);
+		break;
+	case op_exit:
+		fprintf(_c_listing, "  exit");
+		break;
+	default:
+		break;
 	}
+	fprintf(_c_listing, "\n");
 }
 
-/* calculates total binary code length based on IL ops */
-int c_calculate_code_length()
+/* generates code once without keeping it to measure variable length instructions, branches to code ahead are taken as near */
+void c_measure_code_length(backend_state *state)
 {
-	int code_len = 0, i;
+	int i;
+
+	for (i = 0; i < _il_idx; i++)
+		_il[i].code_offset = -1;
+
+	state->sizing = 1;
 	for (i = 0; i < _il_idx; i++) {
-		_il[i].code_offset = code_len;
+		_il[i].code_offset = _e_code_idx;
+		/* a known length of zero means address was merged into next access */
 		_il[i].op_len = _backend->c_get_code_length(&_il[i]);
-		code_len += _il[i].op_len;
+		c_generate_instr(state, i);
+		_il[i].op_len = _e_code_idx - _il[i].code_offset;
 	}
+
+	_e_code_idx = 0;
+	state->sizing = 0;
+	state->function = NULL;
+	state->block = NULL;
+}
+
+/* jumps and calls whose encoding depends on distance to their target */
+int c_is_branch(il_op op)
+{
+	switch (op) {
+	case op_jump:
+	case op_return:
+	case op_jz:
+	case op_jnz:
+	case op_function_call:
+	case op_tail_call:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* places code and grows branches whose targets are out of reach of their current encoding until all of them fit,
+ * returns code length */
+int c_relax_branches(backend_state *state)
+{
+	int i, len, code_len = 0, grown = 1;
+
+	state->sizing = 1;
+	while (grown) {
+		grown = 0;
+		code_len = 0;
+		for (i = 0; i < _il_idx; i++) {
+			_il[i].code_offset = code_len;
+			code_len += _il[i].op_len;
+		}
+
+		state->function = NULL;
+		for (i = 0; i < _il_idx; i++) {
+			if (_il[i].op == op_entry_point)
+				state->function = find_function(_il[i].string_param1);
+			if (c_is_branch(_il[i].op)) {
+				_e_code_idx = _il[i].code_offset;
+				c_generate_instr(state, i);
+				len = _e_code_idx - _il[i].code_offset;
+				/* distances never shrink while code grows, so neither do branches */
+				if (len > _il[i].op_len) {
+					_il[i].op_len = len;
+					grown = 1;
+				}
+			}
+		}
+	}
+
+	_e_code_idx = 0;
+	state->sizing = 0;
+	state->function = NULL;
+	return code_len;
+}
+
+/* calculates total binary code length based on IL ops, starting from the shortest branches */
+int c_calculate_code_length(backend_state *state)
+{
+	int code_len, i, measure = 0;
+	for (i = 0; i < _il_idx; i++) {
+		_il[i].op_len = _backend->c_get_code_length(&_il[i]);
+		if (_il[i].op_len < 0)
+			measure = 1;
+	}
+
+	/* backend could not tell the length of some instructions */
+	if (measure)
+		c_measure_code_length(state);
+	code_len = c_relax_branches(state);
+
+	/* data section is word aligned */
+	if ((code_len & 3) > 0)
+		code_len = (code_len - (code_len & 3)) + 4;
 	return code_len;
 }
 
 /* main code generation loop */
 void c_generate()
 {
-	int i;
-	int stack_size = 0;
-	block_def *bd = NULL;
+	int i, code_len;
 
 	backend_state state;
 	state.code_start = _e_code_start; /* ELF headers size */
-	state.data_start = c_calculate_code_length();
-	c_size_functions(state.code_start + state.data_start);
+	state.data_start = 0;
+	state.function = NULL;
+	state.block = NULL;
+	state.sizing = 0;
+	c_size_functions(); /* code length depends on where globals are */
+	_e_bss_idx = bss_start();
+	if (_e_placed != NULL)
+		e_place_bss();
+	if (_e_relocatable) {
+		/* object file sections start at zero, addresses are relocated by the linker */
+		state.code_start = 0;
+		e_start_object_symbols();
+	}
+	code_len = c_calculate_code_length(&state);
+
+	/* literals are read-only, they follow the instructions */
+	_e_rodata_start = code_len;
+	code_len = align_offset(code_len + _e_rodata_idx, 4);
+	if (_e_relocatable == 0) {
+		/* data segment gets its own pages, at the same offset within a page as in the file */
+		state.data_start = code_len + ELF_PAGE;
+		c_add_global_symbols(state.code_start + state.data_start);
+		e_relocate_data(state.code_start + _e_rodata_start);
+	}
 
 	for (i = 0; i < _il_idx; i++) {
-		int j;
-		int offset, ofs, val;
-		variable_def *var;
-		function_def *fn;
-
-		il_instr *ii = &_il[i];
-		il_op op = ii->op;
-		state.pc = _e_code_idx;
-		state.dest_reg = _backend->c_dest_reg(ii->param_no);
-		state.op_reg = _backend->c_dest_reg(ii->int_param1);
-
-		/* format IL log prefix */
-		printf("%4d %3d  %#010x     ", i, op, state.code_start + state.pc);
-		for (j = 0; j < _c_block_level; j++)
-			printf("  ");
-
-		switch (op) {
-		case op_load_data_address:
-			/* lookup address of a constant in data section */
-			ofs = state.data_start + ii->int_param1;
-			_backend->op_load_data_address(&state, ofs);
-			printf("  x%d := &data[%d]", state.dest_reg, ii->int_param1);
-			break;
-		case op_load_numeric_constant:
-			/* load numeric constant */
-			val = ii->int_param1;
-			_backend->op_load_numeric_constant(&state, val);
-			printf("  x%d := %d", state.dest_reg, ii->int_param1);
-			break;
-		case op_get_var_addr:
-			/* lookup address of a variable */
-			var = find_global_variable(ii->string_param1);
-			if (var != NULL) {
-				int ofs = state.data_start + var->offset;
-				_backend->op_get_global_addr(&state, ofs);
-			} else {
-				/* need to find the variable offset on stack, i.e. from s0 */
-				var = find_local_variable(ii->string_param1, bd);
-				if (var != NULL) {
-					offset = -var->offset;
-					_backend->op_get_local_addr(&state, offset);
-				} else {
-					/* is it function address? */
-					fn = find_function(ii->string_param1);
-					if (fn != NULL) {
-						int jump_instr_index = fn->entry_point;
-						il_instr *jump_instr = &_il[jump_instr_index];
-						ofs = state.code_start +
-						      jump_instr->code_offset; /* load code offset into variable */
-						_backend->op_get_function_addr(&state, ofs);
-					} else
-						error("Undefined identifier");
-				}
-			}
-			printf("  x%d = &%s", state.dest_reg, ii->string_param1);
-			break;
-		case op_read_addr:
-			/* read (dereference) memory address */
-			_backend->op_read_addr(&state, ii->int_param2);
-			printf("  x%d = *x%d (%d)", state.dest_reg, state.op_reg, ii->int_param2);
-			break;
-		case op_write_addr:
-			/* write at memory address */
-			_backend->op_write_addr(&state, ii->int_param2);
-			printf("  *x%d = x%d (%d)", state.op_reg, state.dest_reg, ii->int_param2);
-			break;
-		case op_jump: {
-			/* unconditional jump to an IL-index */
-			int jump_instr_index = ii->int_param1;
-			il_instr *jump_instr = &_il[jump_instr_index];
-			int jump_location = jump_instr->code_offset;
-			ofs = jump_location - state.pc;
-			_backend->op_jump(ofs);
-			printf("  -> %d", ii->int_param1);
-		} break;
-		case op_return: {
-			/* jump to function exit */
-			function_def *fd = find_function(ii->string_param1);
-			int jump_instr_index = fd->exit_point;
-			il_instr *jump_instr = &_il[jump_instr_index];
-			int jump_location = jump_instr->code_offset;
-			ofs = jump_location - state.pc;
-			_backend->op_return(ofs);
-			printf("  return %s", ii->string_param1);
-		} break;
-		case op_function_call: {
-			/* function call */
-			int jump_instr_index;
-			il_instr *jump_instr;
-			int jump_location;
-
-			/* need to find offset */
-			fn = find_function(ii->string_param1);
-			jump_instr_index = fn->entry_point;
-			jump_instr = &_il[jump_instr_index];
-			jump_location = jump_instr->code_offset;
-			ofs = jump_location - state.pc;
-
-			_backend->op_function_call(&state, ofs);
-			printf("  x%d := %s() @ %d", state.dest_reg, ii->string_param1, fn->entry_point);
-		} break;
-		case op_pointer_call: {
-			/* function pointer call, address in op_reg, result in dest_reg */
-			_backend->op_pointer_call(&state);
-			printf("  x%d := x%d()", state.dest_reg, state.op_reg);
-		} break;
-		case op_push:
-			_backend->op_push(&state);
-			printf("  push x%d", state.dest_reg);
-			break;
-		case op_pop:
-			_backend->op_pop(&state);
-			printf("  pop x%d", state.dest_reg);
-			break;
-		case op_exit_point:
-			/* restore previous frame */
-			_backend->op_exit_point();
-			fn = NULL;
-			printf("  exit %s", ii->string_param1);
-			break;
-		case op_add:
-			_backend->op_alu(&state, op_add);
-			printf("  x%d += x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_sub:
-			_backend->op_alu(&state, op_sub);
-			printf("  x%d -= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_mul:
-			_backend->op_alu(&state, op_mul);
-			printf("  x%d *= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_negate:
-			_backend->op_alu(&state, op_negate);
-			printf("  -x%d", state.dest_reg);
-			break;
-		case op_label:
-			if (ii->string_param1 != NULL)
-				/* TODO: lazy eval */
-				if (strlen(ii->string_param1) > 0)
-					e_add_symbol(ii->string_param1, strlen(ii->string_param1),
-						     state.code_start + state.pc);
-			printf(" _:");
-			break;
-		case op_equals:
-		case op_not_equals:
-		case op_less_than:
-		case op_less_eq_than:
-		case op_greater_than:
-		case op_greater_eq_than:
-			/* we want 1/nonzero if equ, 0 otherwise */
-			_backend->op_cmp(&state, op);
-			switch (op) {
-			case op_equals:
-				printf("  x%d == x%d ?", state.dest_reg, state.op_reg);
-				break;
-			case op_not_equals:
-				printf("  x%d != x%d ?", state.dest_reg, state.op_reg);
-				break;
-			case op_less_than:
-				printf("  x%d < x%d ?", state.dest_reg, state.op_reg);
-				break;
-			case op_greater_eq_than:
-				printf("  x%d >= x%d ?", state.dest_reg, state.op_reg);
-				break;
-			case op_greater_than:
-				printf("  x%d > x%d ?", state.dest_reg, state.op_reg);
-				break;
-			case op_less_eq_than:
-				printf("  x%d <= x%d ?", state.dest_reg, state.op_reg);
-				break;
-			default:
-				break;
-			}
-			break;
-		case op_log_and:
-			_backend->op_log(&state, op);
-			printf("  x%d &&= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_log_or:
-			_backend->op_log(&state, op);
-			printf("  x%d ||= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_bit_and:
-			_backend->op_bit(&state, op);
-			printf("  x%d &= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_bit_or:
-			_backend->op_bit(&state, op);
-			printf("  x%d |= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_bit_lshift:
-			_backend->op_bit(&state, op);
-			printf("  x%d <<= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_bit_rshift:
-			_backend->op_bit(&state, op);
-			printf("  x%d >>= x%d", state.dest_reg, state.op_reg);
-			break;
-		case op_not:
-			/* 1 if zero, 0 if nonzero */
-			_backend->op_bit(&state, op);
-			printf("  !x%d", state.dest_reg);
-			break;
-		case op_jz:
-		case op_jnz: {
-			/* conditional jumps to IL-index */
-			int jump_instr_index = ii->int_param1;
-			il_instr *jump_instr = &_il[jump_instr_index];
-			int jump_location = jump_instr->code_offset;
-			int ofs = jump_location - state.pc - 4;
-			_backend->op_jz(&state, op, ofs);
-			if (op == op_jz)
-				printf("  if 0 -> %d", ii->int_param1);
-			else
-				printf("  if 1 -> %d", ii->int_param1);
-		} break;
-		case op_generic:
-			c_emit(ii->int_param1);
-			printf("  asm %#010x", ii->int_param1);
-			break;
-		case op_block_start:
-			bd = &_blocks[ii->int_param1];
-			if (bd->next_local > 0) {
-				/* reserve stack space for locals */
-				_backend->op_block(-bd->locals_size);
-				stack_size += bd->locals_size;
-			}
-			printf("  {");
-			_c_block_level++;
-			break;
-		case op_block_end:
-			bd = &_blocks[ii->int_param1]; /* should not be necessarry */
-			if (bd->next_local > 0) {
-				/* remove stack space for locals */
-				_backend->op_block(bd->locals_size);
-				stack_size -= bd->locals_size;
-			}
-			/* bd is current block */
-			bd = bd->parent;
-			printf("}");
-			_c_block_level--;
-			break;
-		case op_entry_point: {
-			int pn, ps;
-			fn = find_function(ii->string_param1);
-			ps = fn->params_size;
-
-			/* add to symbol table */
-			e_add_symbol(ii->string_param1, strlen(ii->string_param1), state.code_start + state.pc);
-
-			/* create stack space for params and parent frame */
-			_backend->op_entry_point(ps);
-			stack_size = ps;
-
-			/* push parameters on stack */
-			for (pn = 0; pn < fn->num_params; pn++) {
-				_backend->op_store_param(pn, -fn->param_defs[pn].offset);
-			}
-			printf("%s:", ii->string_param1);
-		} break;
-		case op_start:
-			_backend->op_start();
-			printf("  start");
-			break;
-		case op_syscall:
-			_backend->op_syscall();
-			printf("  syscall");
-			break;
-		case op_exit:
-			_backend->op_exit();
-			printf("  exit");
-			break;
-		default:
-			error("Unsupported IL op");
-		}
-		printf("\n");
+		c_generate_instr(&state, i);
+		c_log_instr(&state, i);
+		if (_e_code_idx - state.pc != _il[i].op_len)
+			error("Code length mismatch");
 	}
 
-	printf("Finished code generation\n");
+	/* literals, then pad up to data section */
+	while (_e_code_idx < _e_rodata_start)
+		e_write_code_byte(0);
+	for (i = 0; i < _e_rodata_idx; i++)
+		e_write_code_byte(_e_rodata[i]);
+	while (_e_code_idx < code_len)
+		e_write_code_byte(0);
+
+	fprintf(_c_listing, "Finished code generation\n");
 }
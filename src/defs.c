@@ -8,13 +8,14 @@
 #define MAX_TYPE_LEN 64
 #define MAX_PARAMS 8
 #define MAX_LOCALS 64
+#define MAX_GLOBALS 256
 #define MAX_FIELDS 64
 #define MAX_FUNCTIONS 1024
 #define MAX_BLOCKS 1048576
 #define MAX_TYPES 64
-#define MAX_IL 262144
+#define MAX_IL 524288
 #define MAX_SOURCE 1048576
-#define MAX_CODE 1048576
+#define MAX_CODE 4194304
 #define MAX_DATA 1048576
 #define MAX_SYMTAB 65536
 #define MAX_STRTAB 65536
@@ -24,11 +25,78 @@
 #define MAX_CONSTANTS 1024
 #define MAX_CASES 128
 #define MAX_NESTING 128
+#define MAX_VALUES 65536
+#define MAX_VALUE_HASH 1024
+#define MAX_LOOPS 256
+#define MAX_HOISTED 4096
+#define MAX_SCHEDULE 30
+#define MAX_CACHE_REGS 10
+#define MAX_REGS 18
+#define MAX_USAGE 512
+#define MAX_POOL 1024
+#define MAX_LITERALS 65536
+#define MAX_LITERAL_HASH 4096
+#define MAX_INITIALIZER 65536
+#define MAX_RELOCS 4096
+#define MAX_RELA 131072
+#define MAX_OBJECTS 256
+#define MAX_LINK_SYMBOLS 8192
+#define MAX_MEMBERS 4096
+#define MAX_PCREL 4096
+#define MAX_CLIB 262144
+#define MAX_PATH_LEN 256
+#define MAX_REQUEST 4096
+#define MAX_REQUEST_ARGS 64
+#define MAX_TARGETS 4
 
 #define ELF_START 0x10000
+#define ELF_PAGE 0x1000
 #define PTR_SIZE 4
 
-typedef enum { a_riscv, a_arm } arch_t;
+/* object file symbols, sections come first as the only local ones */
+#define E_SYM_TEXT 1
+#define E_SYM_DATA 2
+#define E_SYM_BSS 3
+#define E_SYM_LOCALS 4
+#define E_OBJECT_SECTIONS 9
+
+/* compilation cache has a place for each of its entries, the one of a key follows from its hash */
+#define K_DEFAULT_LIMIT 67108864
+#define K_MAGIC 0x6b637672
+#define K_HEADER 28
+
+/* ELF relocation types, the ones rvcc emits and the common ones of gcc and clang objects */
+#define R_RISCV_NONE 0
+#define R_RISCV_32 1
+#define R_RISCV_BRANCH 16
+#define R_RISCV_JAL 17
+#define R_RISCV_CALL 18
+#define R_RISCV_CALL_PLT 19
+#define R_RISCV_PCREL_HI20 23
+#define R_RISCV_PCREL_LO12_I 24
+#define R_RISCV_PCREL_LO12_S 25
+#define R_RISCV_HI20 26
+#define R_RISCV_LO12_I 27
+#define R_RISCV_LO12_S 28
+#define R_RISCV_ALIGN 43
+#define R_RISCV_RVC_BRANCH 44
+#define R_RISCV_RVC_JUMP 45
+#define R_RISCV_RELAX 51
+#define R_ARM_NONE 0
+#define R_ARM_ABS32 2
+#define R_ARM_REL32 3
+#define R_ARM_THM_CALL 10
+#define R_ARM_CALL 28
+#define R_ARM_JUMP24 29
+#define R_ARM_THM_JUMP24 30
+#define R_ARM_V4BX 40
+#define R_ARM_PREL31 42
+#define R_ARM_MOVW_ABS_NC 43
+#define R_ARM_MOVT_ABS 44
+#define R_ARM_THM_MOVW_ABS_NC 47
+#define R_ARM_THM_MOVT_ABS 48
+
+typedef enum { a_riscv, a_riscv_c, a_arm, a_thumb2 } arch_t;
 
 /* builtin types */
 typedef enum { bt_void = 0, bt_int = 1, bt_char = 2, bt_struct = 3 } base_type;
@@ -47,6 +115,8 @@ typedef enum {
 	op_function_call,
 	/* pointer call */
 	op_pointer_call,
+	/* function call reusing caller's frame */
+	op_tail_call,
 	/* function exit code */
 	op_exit_point,
 	/* jump to function exit */
@@ -65,6 +135,8 @@ typedef enum {
 	op_push,
 	/* pop from stack */
 	op_pop,
+	/* copy register */
+	op_move,
 	/* code block start */
 	op_block_start,
 	/* code block end */
@@ -117,6 +189,7 @@ typedef struct {
 	int is_function;
 	int array_size;
 	int offset; /* offset from stack or frame */
+	int init; /* global with an initializer, placed in .data rather than .bss, -1 if defined in another unit */
 } variable_def;
 
 /* function definition */
@@ -124,14 +197,19 @@ typedef struct {
 	variable_def return_def;
 	variable_def param_defs[MAX_PARAMS];
 	int num_params;
-	int entry_point; /* IL index */
+	int entry_point; /* IL index, -1 if defined in another unit */
+	int link_offset; /* code offset in precompiled clib the unit is placed after, -1 if not there */
 	int exit_point; /* IL index */
 	int params_size;
+	int cache_regs; /* callee-saved registers used by the optimizer */
+	int saved_params; /* parameter registers written that the platform ABI has callee-saved */
+	int cache_offset; /* stack offset where they are preserved */
+	int pool_size; /* literal pool entries after exit point, if backend uses one */
 } function_def;
 
 /* block definition */
 typedef struct block_def {
-	variable_def locals[MAX_LOCALS];
+	variable_def *locals; /* MAX_LOCALS, or MAX_GLOBALS in the global block */
 	int next_local;
 	struct block_def *parent;
 	function_def *function;
@@ -144,6 +222,7 @@ typedef struct {
 	char type_name[MAX_TYPE_LEN];
 	base_type base_type;
 	int size;
+	int align; /* address alignment, strictest of the fields for structs */
 	variable_def fields[MAX_FIELDS];
 	int num_fields;
 } type_def;
@@ -159,6 +238,7 @@ typedef struct {
 typedef struct {
 	char alias[MAX_VAR_LEN];
 	char value[MAX_VAR_LEN];
+	int conditional; /* defined under #ifdef, may differ between targets */
 } alias_def;
 
 /* constants for enums */
@@ -167,21 +247,129 @@ typedef struct defs {
 	int value;
 } constant_def;
 
+/* string in the data section, found by content when the same literal appears again */
+typedef struct {
+	int offset; /* in data section, string ends with the literal it belongs to */
+	int next; /* hash chain */
+} literal_def;
+
+/* variable usage collected by the IL optimizer */
+typedef struct {
+	variable_def *var;
+	int global;
+	int escapes; /* address is visible outside of IL reads and writes */
+	int stored; /* written inside loop being optimized */
+	int version; /* bumped by every store that may change it */
+} usage_def;
+
+/* value number used by the IL optimizer */
+typedef struct {
+	il_op op; /* operation producing the value, op_generic if unknown */
+	int v1; /* first operand value, or constant */
+	int v2; /* second operand value, or read size */
+	int mem; /* memory version for reads */
+	variable_def *var; /* variable for address values */
+	char *name; /* symbol for address values */
+	usage_def *base; /* variable an address value points into */
+	int direct; /* address is variable plus constant offset */
+	int cost; /* instructions needed to compute */
+	int weight; /* instructions saved by keeping it in a register */
+	int invariant; /* in loop being optimized, -1 if not known yet */
+	int seen; /* IL index of first computation in current region */
+	int next; /* hash chain */
+} value_def;
+
+/* loop found by the IL optimizer */
+typedef struct {
+	int start; /* IL index of header */
+	int end; /* IL index of last backward jump */
+	int cache_mask; /* cache registers holding hoisted values */
+	int cache_values[MAX_REGS]; /* values held by them */
+	block_def *block; /* scope at header */
+	int calls; /* loop calls functions */
+	int stores; /* loop writes through unknown pointers */
+} loop_def;
+
+/* IL instruction data collected by the IL optimizer */
+typedef struct {
+	int flags;
+	int uses; /* registers read */
+	int defs; /* registers written */
+	int target; /* jump target or -1 */
+	int live; /* registers live after */
+	int live_in; /* registers live before */
+	int vn; /* value computed */
+	int map; /* index in rebuilt IL */
+} il_info_def;
+
+/* instruction, or folded address with its access, reordered by the IL scheduler */
+typedef struct {
+	int first; /* IL index */
+	int count; /* IL instructions */
+	int uses; /* registers read */
+	int defs; /* registers written */
+	int mem; /* 1 reads memory, 2 writes it */
+	int latency; /* cycles until result can be used */
+	int results; /* nodes reading its result, as bits */
+	int after; /* other nodes that must follow it, as bits */
+	int preds; /* nodes still to be placed before it */
+	int ready; /* earliest cycle it can start */
+	int height; /* cycles to end of region through it */
+	int placed;
+} sched_def;
+
 typedef struct {
 	int code_start;
 	int data_start;
 	int dest_reg;
 	int op_reg;
 	int pc;
+	function_def *function; /* function being generated */
+	block_def *block; /* innermost block being generated */
+	int sizing; /* only measuring code length, code is discarded */
+	int reloc_symbol; /* object symbol the instruction refers to, 0 if its address is known */
+	int reloc_addend;
 } backend_state;
 
+/* relocation in an object file, of code or of data */
+typedef struct {
+	int offset; /* in section */
+	int type;
+	int symbol;
+	int addend;
+} reloc_def;
+
+/* object file being linked */
+typedef struct {
+	char *image; /* whole file */
+	int shoff; /* section header table */
+	int shnum;
+	int symtab; /* section index of symbol table */
+	int *kinds; /* output section each section went to: 0 none, 1 code, 2 data, 3 bss */
+	int *places; /* offset of each section in its output section */
+} object_def;
+
+/* symbol defined by an object being linked */
+typedef struct {
+	char *name;
+	int value;
+	int weak; /* another definition replaces it */
+} link_symbol_def;
+
 typedef struct {
 	arch_t arch;
 	char *source_define;
+	int cache_regs; /* callee-saved registers available for hoisted values */
+	int first_saved_param; /* parameter registers from here on are callee-saved in the platform ABI, MAX_PARAMS if none */
+	int global_reg; /* register pointing into global data, 0 if none */
+	int elf_word_reloc; /* relocation type of an address stored in data */
 	int (*elf_machine)();
 	int (*elf_flags)();
+	int (*elf_relocate)(char *, int, int, int, int); /* patches S + A into buffer at index for place P, 0 if unknown */
+	int (*elf_addend)(char *, int, int); /* addend A held by instruction in buffer at index, for REL sections */
 	int (*c_dest_reg)(int);
-	int (*c_get_code_length)(il_instr *);
+	int (*c_get_code_length)(il_instr *); /* -1 if only known once generated */
+	int (*c_get_latency)(il_instr *); /* cycles until result is available to the next instruction */
 	void (*op_load_data_address)(backend_state *, int);
 	void (*op_load_numeric_constant)(backend_state *, int);
 	void (*op_get_global_addr)(backend_state *, int);
@@ -189,13 +377,18 @@ typedef struct {
 	void (*op_get_function_addr)(backend_state *, int);
 	void (*op_read_addr)(backend_state *, int);
 	void (*op_write_addr)(backend_state *, int);
+	void (*op_read_global)(backend_state *, int, int);
+	void (*op_write_global)(backend_state *, int, int);
 	void (*op_jump)(int);
 	void (*op_return)(int);
 	void (*op_function_call)(backend_state *, int);
 	void (*op_pointer_call)(backend_state *);
+	void (*op_tail_call)(int);
+	void (*op_move)(backend_state *);
 	void (*op_push)(backend_state *);
 	void (*op_pop)(backend_state *);
 	void (*op_exit_point)();
+	void (*op_literal_pool)(backend_state *);
 	void (*op_alu)(backend_state *, il_op);
 	void (*op_cmp)(backend_state *, il_op);
 	void (*op_log)(backend_state *, il_op);
@@ -204,7 +397,8 @@ typedef struct {
 	void (*op_block)(int);
 	void (*op_entry_point)(int);
 	void (*op_store_param)(int, int);
+	void (*op_load_param)(int, int);
 	void (*op_start)();
-	void (*op_syscall)();
+	void (*op_syscall)(backend_state *, int, int);
 	void (*op_exit)();
 } backend_def;
@@ -14,6 +14,13 @@ void e_write_data_string(char *vals, int len)
 		_e_data[_e_data_idx++] = vals[i];
 }
 
+void e_write_rodata_string(char *vals, int len)
+{
+	int i;
+	for (i = 0; i < len; i++)
+		_e_rodata[_e_rodata_idx++] = vals[i];
+}
+
 void e_write_header_byte(int val)
 {
 	_e_header[_e_header_idx++] = val;
@@ -37,6 +44,36 @@ int e_write_int(char *buf, int idx, int val)
 	return idx;
 }
 
+int e_write_short(char *buf, int idx, int val)
+{
+	buf[idx++] = e_extract_byte(val, 0);
+	buf[idx++] = e_extract_byte(val, 1);
+	return idx;
+}
+
+int e_read_short(char *buf, int idx)
+{
+	return (buf[idx] & 0xFF) + ((buf[idx + 1] & 0xFF) << 8);
+}
+
+int e_read_int(char *buf, int idx)
+{
+	int i, val = 0;
+	for (i = 3; i >= 0; i--)
+		val = (val << 8) | (buf[idx + i] & 0xFF);
+	return val;
+}
+
+/* turns literal offsets stored by global initializers into addresses */
+void e_relocate_data(int rodata_address)
+{
+	int i, ofs;
+	for (i = 0; i < _e_relocs_idx; i++) {
+		ofs = _e_relocs[i];
+		e_write_int(_e_data, ofs, e_read_int(_e_data, ofs) + rodata_address);
+	}
+}
+
 void e_write_header_int(int val)
 {
 	_e_header_idx = e_write_int(_e_header, _e_header_idx, val);
@@ -57,6 +94,17 @@ void e_write_code_int(int val)
 	_e_code_idx = e_write_int(_e_code, _e_code_idx, val);
 }
 
+void e_write_code_byte(char val)
+{
+	_e_code[_e_code_idx++] = val;
+}
+
+void e_write_code_short(int val)
+{
+	e_write_code_byte(e_extract_byte(val, 0));
+	e_write_code_byte(e_extract_byte(val, 1));
+}
+
 void e_write_data_byte(char val)
 {
 	_e_data[_e_data_idx++] = val;
@@ -67,8 +115,84 @@ void c_emit(int code)
 	e_write_code_int(code);
 }
 
+/* emits 16-bit instruction of variable length instruction sets */
+void c_emit_short(int code)
+{
+	e_write_code_short(code);
+}
+
+/* records relocation of instruction about to be emitted, if it refers to a symbol of an object file */
+void c_reloc(backend_state *state, int type, int bias)
+{
+	reloc_def *rel;
+
+	if ((state->reloc_symbol == 0) || (state->sizing != 0))
+		return;
+	if (_e_rela_idx >= MAX_RELA)
+		error("Too many relocations");
+	rel = &_e_rela[_e_rela_idx++];
+	rel->offset = _e_code_idx;
+	rel->type = type;
+	rel->symbol = state->reloc_symbol;
+	rel->addend = state->reloc_addend + bias;
+}
+
+/* address data section is loaded at, on the page after code */
+int e_data_address()
+{
+	return _e_code_start + _e_code_idx + ELF_PAGE;
+}
+
+void e_add_symbol(char *symbol, int len, int pc);
+
+/* index of named symbol in object symbol table, added if new */
+int e_symbol(char *name)
+{
+	int i;
+
+	for (i = E_SYM_LOCALS; i < _e_symbol_idx; i++)
+		if (strcmp(_e_strtab + e_read_int(_e_symtab, i << 4), name) == 0)
+			return i;
+	e_add_symbol(name, strlen(name), 0);
+	return i;
+}
+
+/* instruction refers to data at offset in data section, relative to .data or .bss in an object file */
+void e_reloc_data(backend_state *state, int ofs)
+{
+	if (_e_relocatable == 0)
+		return;
+	if (ofs < _e_bss_idx) {
+		state->reloc_symbol = E_SYM_DATA;
+		state->reloc_addend = ofs;
+	} else {
+		state->reloc_symbol = E_SYM_BSS;
+		state->reloc_addend = ofs - _e_bss_idx;
+	}
+}
+
+/* instruction refers to literal at offset, which follows code in .text of an object file */
+void e_reloc_rodata(backend_state *state, int ofs)
+{
+	if (_e_relocatable == 0)
+		return;
+	state->reloc_symbol = E_SYM_TEXT;
+	state->reloc_addend = _e_rodata_start + ofs;
+}
+
+/* instruction refers to named function or variable, resolved by the linker in an object file */
+void e_reloc_symbol(backend_state *state, char *name)
+{
+	if (_e_relocatable == 0)
+		return;
+	state->reloc_symbol = e_symbol(name);
+	state->reloc_addend = 0;
+}
+
 void e_generate_header()
 {
+	int data_len = _e_bss_idx; /* .data bytes in the file, .bss follows in memory */
+
 	/* ELF header */
 	e_write_header_int(0x464c457f); /* ELF magic */
 	e_write_header_byte(1); /* 32-bit */
@@ -84,7 +208,7 @@ void e_generate_header()
 	e_write_header_int(1); /* ELF version */
 	e_write_header_int(ELF_START + _e_header_len); /* entry point */
 	e_write_header_int(0x34); /* program header offset */
-	e_write_header_int(_e_header_len + _e_code_idx + _e_data_idx + 39 + _e_symtab_idx +
+	e_write_header_int(_e_header_len + _e_code_idx + data_len + 44 + _e_symtab_idx +
 			   _e_strtab_idx); /* section header offset */
 	/* flags */
 	e_write_header_int(_backend->elf_flags());
@@ -92,38 +216,44 @@ void e_generate_header()
 	e_write_header_byte(0);
 	e_write_header_byte(0x20); /* program header size */
 	e_write_header_byte(0);
-	e_write_header_byte(1); /* number of prog headers */
+	e_write_header_byte(2); /* number of prog headers */
 	e_write_header_byte(0);
 	e_write_header_byte(0x28); /* section header size */
 	e_write_header_byte(0);
-	e_write_header_byte(6); /* number of sections */
+	e_write_header_byte(7); /* number of sections */
 	e_write_header_byte(0);
-	e_write_header_byte(5); /* section index with names */
+	e_write_header_byte(6); /* section index with names */
 	e_write_header_byte(0);
 
-	/* program header - code and data combined */
+	/* program header - headers and code, read-only */
 	e_write_header_int(1); /* PT_LOAD */
-	e_write_header_int(_e_header_len); /* offset */
-	e_write_header_int(ELF_START + _e_header_len); /* virtual address */
-	e_write_header_int(ELF_START + _e_header_len); /* physical address */
-	e_write_header_int(_e_code_idx + _e_data_idx); /* size in file */
-	e_write_header_int(_e_code_idx + _e_data_idx); /* size in memory */
-	e_write_header_int(7); /* flags */
-	e_write_header_int(4); /* alignment */
+	e_write_header_int(0); /* offset */
+	e_write_header_int(ELF_START); /* virtual address */
+	e_write_header_int(ELF_START); /* physical address */
+	e_write_header_int(_e_header_len + _e_code_idx); /* size in file */
+	e_write_header_int(_e_header_len + _e_code_idx); /* size in memory */
+	e_write_header_int(5); /* flags: R-X */
+	e_write_header_int(ELF_PAGE); /* alignment */
+
+	/* program header - data on the page after code, zero-filled .bss past the file bytes */
+	e_write_header_int(1); /* PT_LOAD */
+	e_write_header_int(_e_header_len + _e_code_idx); /* offset */
+	e_write_header_int(e_data_address()); /* virtual address */
+	e_write_header_int(e_data_address()); /* physical address */
+	e_write_header_int(data_len); /* size in file */
+	e_write_header_int(_e_data_idx); /* size in memory */
+	e_write_header_int(6); /* flags: RW- */
+	e_write_header_int(ELF_PAGE); /* alignment */
 }
 
 void e_generate_footer()
 {
-	/* symtab section */
-	int b;
-	for (b = 0; b < _e_symtab_idx; b++)
-		e_write_footer_byte(_e_symtab[b]);
+	int data_len = _e_bss_idx;
+	int data_addr = e_data_address();
 
-	/* strtab section */
-	for (b = 0; b < _e_strtab_idx; b++)
-		e_write_footer_byte(_e_strtab[b]);
+	/* symtab and strtab sections are written straight from their buffers */
 
-	/* shstr section; len = 39 */
+	/* shstr section; len = 44 */
 	e_write_footer_byte(0);
 	e_write_footer_string(".shstrtab", 9);
 	e_write_footer_byte(0);
@@ -135,6 +265,8 @@ void e_generate_footer()
 	e_write_footer_byte(0);
 	e_write_footer_string(".strtab", 7);
 	e_write_footer_byte(0);
+	e_write_footer_string(".bss", 4);
+	e_write_footer_byte(0);
 
 	/* section header table */
 
@@ -153,7 +285,7 @@ void e_generate_footer()
 	/* .text */
 	e_write_footer_int(0xb);
 	e_write_footer_int(1);
-	e_write_footer_int(7);
+	e_write_footer_int(6);
 	e_write_footer_int(ELF_START + _e_header_len);
 	e_write_footer_int(_e_header_len);
 	e_write_footer_int(_e_code_idx);
@@ -166,9 +298,21 @@ void e_generate_footer()
 	e_write_footer_int(0x11);
 	e_write_footer_int(1);
 	e_write_footer_int(3);
-	e_write_footer_int(_e_code_start + _e_code_idx);
+	e_write_footer_int(data_addr);
 	e_write_footer_int(_e_header_len + _e_code_idx);
-	e_write_footer_int(_e_data_idx);
+	e_write_footer_int(data_len);
+	e_write_footer_int(0);
+	e_write_footer_int(0);
+	e_write_footer_int(4);
+	e_write_footer_int(0);
+
+	/* .bss */
+	e_write_footer_int(0x27);
+	e_write_footer_int(8);
+	e_write_footer_int(3);
+	e_write_footer_int(data_addr + data_len);
+	e_write_footer_int(_e_header_len + _e_code_idx + data_len);
+	e_write_footer_int(_e_data_idx - data_len);
 	e_write_footer_int(0);
 	e_write_footer_int(0);
 	e_write_footer_int(4);
@@ -179,9 +323,9 @@ void e_generate_footer()
 	e_write_footer_int(2);
 	e_write_footer_int(0);
 	e_write_footer_int(0);
-	e_write_footer_int(_e_header_len + _e_code_idx + _e_data_idx);
+	e_write_footer_int(_e_header_len + _e_code_idx + data_len);
 	e_write_footer_int(_e_symtab_idx); /* size */
-	e_write_footer_int(4);
+	e_write_footer_int(5);
 	e_write_footer_int(_e_symbol_idx);
 	e_write_footer_int(4);
 	e_write_footer_int(16);
@@ -191,7 +335,7 @@ void e_generate_footer()
 	e_write_footer_int(3);
 	e_write_footer_int(0);
 	e_write_footer_int(0);
-	e_write_footer_int(_e_header_len + _e_code_idx + _e_data_idx + _e_symtab_idx);
+	e_write_footer_int(_e_header_len + _e_code_idx + data_len + _e_symtab_idx);
 	e_write_footer_int(_e_strtab_idx); /* size */
 	e_write_footer_int(0);
 	e_write_footer_int(0);
@@ -203,8 +347,8 @@ void e_generate_footer()
 	e_write_footer_int(3);
 	e_write_footer_int(0);
 	e_write_footer_int(0);
-	e_write_footer_int(_e_header_len + _e_code_idx + _e_data_idx + _e_symtab_idx + _e_strtab_idx);
-	e_write_footer_int(39);
+	e_write_footer_int(_e_header_len + _e_code_idx + data_len + _e_symtab_idx + _e_strtab_idx);
+	e_write_footer_int(44);
 	e_write_footer_int(0);
 	e_write_footer_int(0);
 	e_write_footer_int(1);
@@ -245,20 +389,17 @@ void e_add_symbol(char *symbol, int len, int pc)
 void e_output(char *outfile)
 {
 	FILE *fp;
-	int i;
 
 	if (outfile == NULL)
 		outfile = "out.elf";
 
 	fp = fopen(outfile, "wb");
-	for (i = 0; i < _e_header_idx; i++)
-		fputc(_e_header[i], fp);
-	for (i = 0; i < _e_code_idx; i++)
-		fputc(_e_code[i], fp);
-	for (i = 0; i < _e_data_idx; i++)
-		fputc(_e_data[i], fp);
-	for (i = 0; i < _e_footer_idx; i++)
-		fputc(_e_footer[i], fp);
+	fwrite(_e_header, 1, _e_header_idx, fp);
+	fwrite(_e_code, 1, _e_code_idx, fp);
+	fwrite(_e_data, 1, _e_bss_idx, fp);
+	fwrite(_e_symtab, 1, _e_symtab_idx, fp);
+	fwrite(_e_strtab, 1, _e_strtab_idx, fp);
+	fwrite(_e_footer, 1, _e_footer_idx, fp);
 	fclose(fp);
 }
 
@@ -269,3 +410,780 @@ void e_generate(char *outfile)
 	e_generate_footer();
 	e_output(outfile);
 }
+
+/* starts object symbol table with a section symbol for each of .text, .data and .bss */
+void e_start_object_symbols()
+{
+	int i;
+
+	_e_symtab_idx = 0;
+	_e_strtab_idx = 0;
+	_e_symbol_idx = 0;
+	e_add_symbol("", 0, 0);
+	for (i = E_SYM_TEXT; i < E_SYM_LOCALS; i++) {
+		e_write_symbol_int(0);
+		e_write_symbol_int(0);
+		e_write_symbol_int(0);
+		e_write_symbol_int(3 + (i << 16)); /* STB_LOCAL, STT_SECTION */
+		_e_symbol_idx++;
+	}
+}
+
+/* completes object symbol table with definitions nothing referred to, and where each symbol is */
+void e_finish_object_symbols()
+{
+	block_def *bd = &_blocks[0];
+	function_def *fn;
+	variable_def *var;
+	char *name;
+	int i, ofs, value, size, info, section;
+
+	for (i = 0; i < _functions_idx; i++)
+		if (_functions[i].entry_point >= 0)
+			e_symbol(_functions[i].return_def.variable_name);
+	for (i = 0; i < bd->next_local; i++)
+		if (bd->locals[i].init >= 0)
+			e_symbol(bd->locals[i].variable_name);
+	/* clib's startup code points the global register where the unit placed after it expects */
+	if ((_e_placed != NULL) && (_backend->global_reg != 0))
+		e_symbol("__global_pointer$");
+
+	for (i = E_SYM_LOCALS; i < _e_symbol_idx; i++) {
+		ofs = i << 4;
+		name = _e_strtab + e_read_int(_e_symtab, ofs);
+		value = 0;
+		size = 0;
+		info = 16; /* STB_GLOBAL, undefined */
+		section = 0;
+		fn = find_function(name);
+		var = find_global_variable(name);
+		if (fn != NULL) {
+			if (fn->entry_point >= 0) {
+				value = _il[fn->entry_point].code_offset;
+				if (_backend->arch == a_thumb2)
+					value++; /* Thumb code */
+				info = 18; /* STT_FUNC */
+				section = E_SYM_TEXT;
+			}
+		} else if ((_e_placed != NULL) && (strcmp(name, "__global_pointer$") == 0)) {
+			value = data_anchor();
+			section = E_SYM_DATA;
+			if (value >= _e_bss_idx) {
+				value -= _e_bss_idx;
+				section = E_SYM_BSS;
+			}
+		} else if (var != NULL) {
+			if (var->init >= 0) {
+				value = var->offset;
+				size = size_variable(var);
+				info = 17; /* STT_OBJECT */
+				section = E_SYM_DATA;
+				if (var->init == 0) {
+					value -= _e_bss_idx;
+					section = E_SYM_BSS;
+				}
+			}
+		}
+		e_write_int(_e_symtab, ofs + 4, value);
+		e_write_int(_e_symtab, ofs + 8, size);
+		e_write_int(_e_symtab, ofs + 12, info + (section << 16));
+	}
+}
+
+void e_write_section_header(int name, int type, int flags, int offset, int size, int link)
+{
+	e_write_footer_int(name);
+	e_write_footer_int(type);
+	e_write_footer_int(flags);
+	e_write_footer_int(0); /* address */
+	e_write_footer_int(offset);
+	e_write_footer_int(size);
+	e_write_footer_int(link);
+}
+
+/* writes relocations of code or data as Elf32_Rela entries */
+int e_write_relocations(char *image, int idx, reloc_def *rels, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		idx = e_write_int(image, idx, rels[i].offset);
+		idx = e_write_int(image, idx, (rels[i].symbol << 8) + rels[i].type);
+		idx = e_write_int(image, idx, rels[i].addend);
+	}
+	return idx;
+}
+
+/* lays out relocatable object in memory: code, data, symbols and relocations of both */
+char *e_generate_object()
+{
+	int text_ofs = 0x34, data_ofs, sym_ofs, str_ofs, rela_ofs, rela_data_ofs, shstr_ofs, sh_ofs, i;
+	backend_state state;
+	reloc_def *data_rels;
+	char *image;
+
+	e_align();
+	e_finish_object_symbols();
+
+	/* initializers holding literal offsets become relocations against .text */
+	data_rels = malloc((_e_relocs_idx + 1) * sizeof(reloc_def));
+	for (i = 0; i < _e_relocs_idx; i++) {
+		e_reloc_rodata(&state, e_read_int(_e_data, _e_relocs[i]));
+		data_rels[i].offset = _e_relocs[i];
+		data_rels[i].type = _backend->elf_word_reloc;
+		data_rels[i].symbol = state.reloc_symbol;
+		data_rels[i].addend = state.reloc_addend;
+	}
+
+	data_ofs = text_ofs + _e_code_idx;
+	sym_ofs = align_offset(data_ofs + _e_bss_idx, 4);
+	str_ofs = sym_ofs + _e_symtab_idx;
+	rela_ofs = align_offset(str_ofs + _e_strtab_idx, 4);
+	rela_data_ofs = rela_ofs + (_e_rela_idx * 12);
+	shstr_ofs = rela_data_ofs + (_e_relocs_idx * 12);
+	sh_ofs = align_offset(shstr_ofs + 66, 4);
+
+	/* ELF header */
+	_e_header_idx = 0;
+	e_write_header_int(0x464c457f); /* ELF magic */
+	e_write_header_byte(1); /* 32-bit */
+	e_write_header_byte(1); /* little-endian */
+	e_write_header_byte(1);
+	e_write_header_byte(0); /* System V */
+	e_write_header_int(0);
+	e_write_header_int(0);
+	e_write_header_byte(1); /* ET_REL */
+	e_write_header_byte(0);
+	e_write_header_byte(_backend->elf_machine());
+	e_write_header_byte(0);
+	e_write_header_int(1); /* ELF version */
+	e_write_header_int(0); /* no entry point */
+	e_write_header_int(0); /* no program headers */
+	e_write_header_int(sh_ofs); /* section header offset */
+	e_write_header_int(_backend->elf_flags());
+	e_write_header_byte(0x34); /* header size */
+	e_write_header_byte(0);
+	e_write_header_byte(0); /* program header size */
+	e_write_header_byte(0);
+	e_write_header_byte(0); /* number of prog headers */
+	e_write_header_byte(0);
+	e_write_header_byte(0x28); /* section header size */
+	e_write_header_byte(0);
+	e_write_header_byte(E_OBJECT_SECTIONS); /* number of sections */
+	e_write_header_byte(0);
+	e_write_header_byte(8); /* section index with names */
+	e_write_header_byte(0);
+
+	/* shstr section; len = 66 */
+	_e_footer_idx = 0;
+	e_write_footer_byte(0);
+	e_write_footer_string(".text", 5);
+	e_write_footer_byte(0);
+	e_write_footer_string(".data", 5);
+	e_write_footer_byte(0);
+	e_write_footer_string(".bss", 4);
+	e_write_footer_byte(0);
+	e_write_footer_string(".symtab", 7);
+	e_write_footer_byte(0);
+	e_write_footer_string(".strtab", 7);
+	e_write_footer_byte(0);
+	e_write_footer_string(".rela.text", 10);
+	e_write_footer_byte(0);
+	e_write_footer_string(".rela.data", 10);
+	e_write_footer_byte(0);
+	e_write_footer_string(".shstrtab", 9);
+	e_write_footer_byte(0);
+	while (_e_footer_idx < sh_ofs - shstr_ofs)
+		e_write_footer_byte(0);
+
+	/* section header table: name, type, flags, address, offset, size, link, then info, alignment and entry size */
+	for (i = 0; i < 10; i++)
+		e_write_footer_int(0);
+	e_write_section_header(1, 1, 6, text_ofs, _e_code_idx, 0);
+	e_write_footer_int(0);
+	e_write_footer_int(4);
+	e_write_footer_int(0);
+	e_write_section_header(7, 1, 3, data_ofs, _e_bss_idx, 0);
+	e_write_footer_int(0);
+	e_write_footer_int(4);
+	e_write_footer_int(0);
+	e_write_section_header(13, 8, 3, data_ofs + _e_bss_idx, _e_data_idx - _e_bss_idx, 0);
+	e_write_footer_int(0);
+	e_write_footer_int(4);
+	e_write_footer_int(0);
+	e_write_section_header(18, 2, 0, sym_ofs, _e_symtab_idx, 5);
+	e_write_footer_int(E_SYM_LOCALS);
+	e_write_footer_int(4);
+	e_write_footer_int(16);
+	e_write_section_header(26, 3, 0, str_ofs, _e_strtab_idx, 0);
+	e_write_footer_int(0);
+	e_write_footer_int(1);
+	e_write_footer_int(0);
+	e_write_section_header(34, 4, 0x40, rela_ofs, _e_rela_idx * 12, 4);
+	e_write_footer_int(E_SYM_TEXT);
+	e_write_footer_int(4);
+	e_write_footer_int(12);
+	e_write_section_header(45, 4, 0x40, rela_data_ofs, _e_relocs_idx * 12, 4);
+	e_write_footer_int(E_SYM_DATA);
+	e_write_footer_int(4);
+	e_write_footer_int(12);
+	e_write_section_header(56, 3, 0, shstr_ofs, 66, 0);
+	e_write_footer_int(0);
+	e_write_footer_int(1);
+	e_write_footer_int(0);
+
+	image = calloc(shstr_ofs + _e_footer_idx, 1);
+	memcpy(image, _e_header, _e_header_idx);
+	memcpy(image + text_ofs, _e_code, _e_code_idx);
+	memcpy(image + data_ofs, _e_data, _e_bss_idx);
+	memcpy(image + sym_ofs, _e_symtab, _e_symtab_idx);
+	memcpy(image + str_ofs, _e_strtab, _e_strtab_idx);
+	e_write_relocations(image, rela_ofs, _e_rela, _e_rela_idx);
+	e_write_relocations(image, rela_data_ofs, data_rels, _e_relocs_idx);
+	memcpy(image + shstr_ofs, _e_footer, _e_footer_idx);
+	free(data_rels);
+	return image;
+}
+
+/* writes object file, which ends with its section header table */
+void e_output_object(char *outfile, char *image)
+{
+	FILE *fp;
+
+	if (outfile == NULL)
+		outfile = "out.o";
+
+	fp = fopen(outfile, "wb");
+	fwrite(image, 1, e_read_int(image, 32) + (e_read_short(image, 48) * 40), fp);
+	fclose(fp);
+}
+
+void e_clib_riscv();
+void e_clib_riscv_c();
+void e_clib_arm();
+void e_clib_thumb2();
+
+int e_hex_digit(char c)
+{
+	if (c <= '9')
+		return c - '0';
+	return (c - 'a') + 10;
+}
+
+/* appends bytes written in hex to precompiled clib object */
+void __o(char *hex)
+{
+	int i = 0;
+
+	while (hex[i] != 0) {
+		if (_e_clib_idx >= MAX_CLIB)
+			error("Precompiled clib too large");
+		_e_clib[_e_clib_idx++] = (e_hex_digit(hex[i]) << 4) + e_hex_digit(hex[i + 1]);
+		i += 2;
+	}
+}
+
+/* startup code and clib object make clib precompiled for architecture, NULL if it has none */
+char *e_clib_object(arch_t arch)
+{
+	_e_clib_idx = 0;
+	switch (arch) {
+	case a_riscv:
+		e_clib_riscv();
+		break;
+	case a_riscv_c:
+		e_clib_riscv_c();
+		break;
+	case a_arm:
+		e_clib_arm();
+		break;
+	case a_thumb2:
+		e_clib_thumb2();
+		break;
+	default:
+		break;
+	}
+	if (_e_clib_idx == 0)
+		return NULL;
+	return _e_clib;
+}
+
+/* reads whole file into memory, setting its size */
+char *e_read_file(char *file, int *size)
+{
+	FILE *fp;
+	char *image;
+	int alloc = 65536, len = 0, n = 1;
+
+	fp = fopen(file, "rb");
+	if (fp == NULL)
+		error("Unable to open input file");
+	image = malloc(alloc);
+	while (n > 0) {
+		if (len == alloc) {
+			alloc = alloc << 1;
+			image = realloc(image, alloc);
+		}
+		n = fread(image + len, 1, alloc - len, fp);
+		len += n;
+	}
+	fclose(fp);
+	size[0] = len;
+	return image;
+}
+
+/* field of section header, fields are numbered from sh_name */
+int e_section_field(object_def *obj, int section, int field)
+{
+	return e_read_int(obj->image, (obj->shoff + (section * 40)) + (field << 2));
+}
+
+/* reads headers of relocatable object for the target architecture */
+void e_open_object(object_def *obj, char *image)
+{
+	int i;
+
+	if (e_read_int(image, 0) != 0x464c457f)
+		error("Not an ELF file");
+	if (e_read_short(image, 16) != 1)
+		error("Not a relocatable object");
+	if (e_read_short(image, 18) != _backend->elf_machine())
+		error("Object is for another architecture");
+
+	obj->image = image;
+	obj->shoff = e_read_int(image, 32);
+	obj->shnum = e_read_short(image, 48);
+	obj->kinds = calloc(obj->shnum, sizeof(int));
+	obj->places = calloc(obj->shnum, sizeof(int));
+	obj->symtab = 0;
+	for (i = 0; i < obj->shnum; i++)
+		if (e_section_field(obj, i, 1) == 2) /* SHT_SYMTAB */
+			obj->symtab = i;
+}
+
+/* adds relocatable object to be linked */
+void e_add_object(char *image)
+{
+	if (_e_objects_idx >= MAX_OBJECTS)
+		error("Too many objects");
+	e_open_object(&_e_objects[_e_objects_idx++], image);
+}
+
+/* adds objects of ar archive, each one only linked if it defines a symbol other objects are missing */
+void e_add_archive(char *image, int size)
+{
+	int ofs = 8, len, i;
+
+	while ((ofs + 60) <= size) {
+		/* member header is text, size is a decimal field */
+		len = 0;
+		for (i = 48; i < 58; i++)
+			if ((image[ofs + i] >= '0') && (image[ofs + i] <= '9'))
+				len = (len * 10) + (image[ofs + i] - '0');
+		ofs += 60;
+
+		/* symbol index and long names are not objects */
+		if (e_read_int(image, ofs) == 0x464c457f) {
+			if (_e_members_idx >= MAX_MEMBERS)
+				error("Too many archive members");
+			e_open_object(&_e_members[_e_members_idx++], image + ofs);
+		}
+		ofs += len + (len & 1);
+	}
+}
+
+/* adds object or archive file to be linked */
+void e_add_file(char *file)
+{
+	int size;
+	char *image = e_read_file(file, &size);
+
+	if (strncmp(image, "!<arch>\n", 8) == 0)
+		e_add_archive(image, size);
+	else
+		e_add_object(image);
+}
+
+/* output section an object section goes to: 1 code, 2 data, 3 bss, 0 if it is not loaded */
+int e_section_kind(object_def *obj, int section)
+{
+	int type = e_section_field(obj, section, 1), flags = e_section_field(obj, section, 2);
+	int names = e_section_field(obj, e_read_short(obj->image, 50), 4);
+
+	if ((flags & 2) == 0) /* SHF_ALLOC */
+		return 0;
+	if (type == 8) /* SHT_NOBITS */
+		return 3;
+	if (type != 1) /* SHT_PROGBITS */
+		return 0;
+	/* unwind tables of foreign objects, nothing unwinds */
+	if (strcmp(obj->image + (names + e_section_field(obj, section, 0)), ".eh_frame") == 0)
+		return 0;
+	if ((flags & 4) != 0) /* SHF_EXECINSTR */
+		return 1;
+	return 2;
+}
+
+/* appends sections of given kind of all objects to code or data, at their alignment */
+void e_place_sections(int kind)
+{
+	object_def *obj;
+	int i, j, align, size;
+
+	for (i = 0; i < _e_objects_idx; i++) {
+		obj = &_e_objects[i];
+		for (j = 0; j < obj->shnum; j++)
+			if (e_section_kind(obj, j) == kind) {
+				align = e_section_field(obj, j, 8);
+				if (align < 1)
+					align = 1;
+				size = e_section_field(obj, j, 5);
+				obj->kinds[j] = kind;
+				if (kind == 1) {
+					while (_e_code_idx < align_offset(_e_code_idx, align))
+						e_write_code_byte(0);
+					obj->places[j] = _e_code_idx;
+					memcpy(_e_code + _e_code_idx, obj->image + e_section_field(obj, j, 4), size);
+					_e_code_idx += size;
+				} else {
+					while (_e_data_idx < align_offset(_e_data_idx, align))
+						e_write_data_byte(0);
+					obj->places[j] = _e_data_idx;
+					if (kind == 2)
+						memcpy(_e_data + _e_data_idx, obj->image + e_section_field(obj, j, 4), size);
+					else
+						memset(_e_data + _e_data_idx, 0, size);
+					_e_data_idx += size;
+				}
+			}
+	}
+}
+
+/* address of object section once placed */
+int e_section_address(object_def *obj, int section)
+{
+	if (obj->kinds[section] == 1)
+		return _e_code_start + obj->places[section];
+	return e_data_address() + obj->places[section];
+}
+
+link_symbol_def *e_find_link_symbol(char *name)
+{
+	int i;
+
+	for (i = 0; i < _e_link_symbols_idx; i++)
+		if (strcmp(_e_link_symbols[i].name, name) == 0)
+			return &_e_link_symbols[i];
+	return NULL;
+}
+
+void e_add_link_symbol(char *name, int value, int weak)
+{
+	link_symbol_def *sym;
+
+	if (_e_link_symbols_idx >= MAX_LINK_SYMBOLS)
+		error("Too many symbols");
+	sym = &_e_link_symbols[_e_link_symbols_idx++];
+	sym->name = name;
+	sym->value = value;
+	sym->weak = weak;
+}
+
+/* offset of symbol table entry of object */
+int e_symbol_entry(object_def *obj, int sym)
+{
+	return e_section_field(obj, obj->symtab, 4) + (sym << 4);
+}
+
+/* number of symbols of object */
+int e_symbol_count(object_def *obj)
+{
+	if (obj->symtab == 0)
+		return 0;
+	return e_section_field(obj, obj->symtab, 5) >> 4;
+}
+
+/* binding of symbol: 0 local, 1 global, 2 weak */
+int e_symbol_binding(object_def *obj, int sym)
+{
+	return (obj->image[e_symbol_entry(obj, sym) + 12] >> 4) & 15;
+}
+
+/* section index of symbol, 0 if undefined */
+int e_symbol_section(object_def *obj, int sym)
+{
+	return e_read_short(obj->image, e_symbol_entry(obj, sym) + 14);
+}
+
+/* name of symbol in object's symbol table */
+char *e_symbol_name(object_def *obj, int sym)
+{
+	int strtab = e_section_field(obj, obj->symtab, 6);
+
+	return (obj->image + e_section_field(obj, strtab, 4)) + e_read_int(obj->image, e_symbol_entry(obj, sym));
+}
+
+/* does object refer to global symbol without defining it, and no other object being linked defines it */
+int e_symbol_missing(char *name)
+{
+	object_def *obj;
+	int i, j, missing = 0;
+
+	for (i = 0; i < _e_objects_idx; i++) {
+		obj = &_e_objects[i];
+		for (j = 1; j < e_symbol_count(obj); j++)
+			if (e_symbol_binding(obj, j) != 0)
+				if (strcmp(e_symbol_name(obj, j), name) == 0) {
+					if (e_symbol_section(obj, j) != 0)
+						return 0;
+					/* weak references do not pull in archive members */
+					if (e_symbol_binding(obj, j) == 1)
+						missing = 1;
+				}
+	}
+	return missing;
+}
+
+/* links archive members defining symbols that are still missing, until none of them is */
+void e_link_members()
+{
+	object_def *obj;
+	int i, j, count, pulled = 1;
+
+	while (pulled) {
+		pulled = 0;
+		for (i = 0; i < _e_members_idx; i++) {
+			obj = &_e_members[i];
+			count = 0;
+			if (obj->image != NULL)
+				count = e_symbol_count(obj);
+			for (j = 1; j < count; j++)
+				if (obj->image != NULL)
+					if ((e_symbol_binding(obj, j) != 0) && (e_symbol_section(obj, j) != 0))
+						if (e_symbol_missing(e_symbol_name(obj, j))) {
+							if (_e_objects_idx >= MAX_OBJECTS)
+								error("Too many objects");
+							memcpy(&_e_objects[_e_objects_idx++], obj, sizeof(object_def));
+							obj->image = NULL;
+							pulled = 1;
+						}
+		}
+	}
+}
+
+/* address of symbol of object, looked up among all objects if object only refers to it */
+int e_symbol_value(object_def *obj, int sym)
+{
+	int ofs = e_symbol_entry(obj, sym);
+	int section = e_symbol_section(obj, sym);
+	link_symbol_def *def;
+	char *name;
+
+	if (sym == 0) /* STN_UNDEF, relocation without a symbol */
+		return 0;
+	if ((section == 0) || (section == 65522)) {
+		name = e_symbol_name(obj, sym);
+		def = e_find_link_symbol(name);
+		if (def != NULL)
+			return def->value;
+		if (e_symbol_binding(obj, sym) == 2)
+			return 0; /* undefined weak */
+		printf("Symbol %s\n", name);
+		error("Undefined symbol");
+	}
+	if (section >= obj->shnum)
+		return e_read_int(obj->image, ofs + 4); /* SHN_ABS */
+	return e_section_address(obj, section) + e_read_int(obj->image, ofs + 4);
+}
+
+/* collects global symbols object defines, a weak definition gives way to a global one */
+void e_define_symbols(object_def *obj)
+{
+	int i, binding, section;
+	link_symbol_def *def;
+	char *name;
+
+	for (i = 1; i < e_symbol_count(obj); i++) {
+		binding = e_symbol_binding(obj, i);
+		section = e_symbol_section(obj, i);
+		/* common symbols are placed once all definitions are known */
+		if ((binding != 0) && (section != 0) && (section != 65522)) {
+			name = e_symbol_name(obj, i);
+			def = e_find_link_symbol(name);
+			if (def == NULL)
+				e_add_link_symbol(name, e_symbol_value(obj, i), binding == 2);
+			else if ((def->weak == 1) && (binding != 2)) {
+				def->value = e_symbol_value(obj, i);
+				def->weak = 0;
+			} else if ((def->weak == 0) && (binding != 2)) {
+				printf("Symbol %s\n", name);
+				error("Duplicate symbol");
+			}
+		}
+	}
+}
+
+/* places common symbols nothing defined at the end of .bss, value of common symbol is its alignment */
+void e_define_commons(object_def *obj)
+{
+	int i, ofs;
+	char *name;
+
+	for (i = 1; i < e_symbol_count(obj); i++)
+		if (e_symbol_section(obj, i) == 65522) { /* SHN_COMMON */
+			name = e_symbol_name(obj, i);
+			if (e_find_link_symbol(name) == NULL) {
+				ofs = e_symbol_entry(obj, i);
+				while (_e_data_idx < align_offset(_e_data_idx, e_read_int(obj->image, ofs + 4)))
+					e_write_data_byte(0);
+				e_add_link_symbol(name, e_data_address() + _e_data_idx, 0);
+				for (ofs = e_read_int(obj->image, ofs + 8); ofs > 0; ofs--)
+					e_write_data_byte(0);
+			}
+		}
+}
+
+/* patches code and data of object with addresses of what they refer to, addends are in RELA entries or in place for REL */
+void e_apply_relocations(object_def *obj)
+{
+	int i, type, target, ofs, end, size, info, place, idx, value;
+	char *buf;
+
+	for (i = 0; i < obj->shnum; i++) {
+		type = e_section_field(obj, i, 1);
+		target = e_section_field(obj, i, 7);
+		if (((type == 4) || (type == 9)) && (obj->kinds[target] != 0)) { /* SHT_RELA, SHT_REL */
+			buf = _e_data;
+			if (obj->kinds[target] == 1)
+				buf = _e_code;
+			size = 8;
+			if (type == 4)
+				size = 12;
+			ofs = e_section_field(obj, i, 4);
+			end = ofs + e_section_field(obj, i, 5);
+			while (ofs < end) {
+				info = e_read_int(obj->image, ofs + 4);
+				idx = e_read_int(obj->image, ofs) + obj->places[target];
+				place = e_section_address(obj, target) + e_read_int(obj->image, ofs);
+				if (type == 4)
+					value = e_read_int(obj->image, ofs + 8);
+				else
+					value = _backend->elf_addend(buf, idx, info & 0xFF);
+				value += e_symbol_value(obj, info >> 8);
+				if (_backend->elf_relocate(buf, idx, info & 0xFF, value, place) == 0) {
+					printf("Relocation type %d\n", info & 0xFF);
+					error("Unsupported relocation");
+				}
+				ofs += size;
+			}
+		}
+	}
+}
+
+/* offset after object's sections of given kind, placed from start as e_place_sections does */
+int e_plan_sections(object_def *obj, int kind, int start)
+{
+	int j, align;
+
+	for (j = 0; j < obj->shnum; j++)
+		if (e_section_kind(obj, j) == kind) {
+			align = e_section_field(obj, j, 8);
+			if (align < 1)
+				align = 1;
+			start = align_offset(start, align);
+			obj->places[j] = start;
+			start += e_section_field(obj, j, 5);
+		}
+	return start;
+}
+
+/* the unit is linked right after precompiled clib, code is generated for where it goes: data in reach of the global
+ * register and calls into clib need no relocation */
+void e_place_after(char *image)
+{
+	object_def *obj = malloc(sizeof(object_def));
+	function_def *fn;
+	int i, value;
+
+	e_open_object(obj, image);
+	_e_placed = obj;
+	_e_placed_code = align_offset(e_plan_sections(obj, 1, 0), 4);
+	_e_placed_data = align_offset(e_plan_sections(obj, 2, 0), 4);
+
+	for (i = 1; i < e_symbol_count(obj); i++)
+		if ((e_symbol_binding(obj, i) != 0) && (e_symbol_section(obj, i) != 0) && (e_symbol_section(obj, i) < obj->shnum))
+			if (e_section_kind(obj, e_symbol_section(obj, i)) == 1) {
+				fn = find_function(e_symbol_name(obj, i));
+				if (fn != NULL)
+					if (fn->entry_point < 0) {
+						value = e_read_int(obj->image, e_symbol_entry(obj, i) + 4);
+						value += obj->places[e_symbol_section(obj, i)];
+						fn->link_offset = value - (value & 1); /* Thumb code */
+					}
+			}
+}
+
+/* places the unit's .bss, once the size of its .data is known: all .data goes first, then .bss of each object */
+void e_place_bss()
+{
+	_e_placed_bss = align_offset(e_plan_sections(_e_placed, 3, align_offset(_e_placed_data + _e_bss_idx, 4)), 4);
+}
+
+/* offset of data at offset of the unit in linked data */
+int e_placed_offset(int ofs)
+{
+	if (ofs < _e_bss_idx)
+		return _e_placed_data + ofs;
+	return _e_placed_bss + (ofs - _e_bss_idx);
+}
+
+/* distance of data at offset from where the global register points */
+int e_anchor_distance(int ofs)
+{
+	if (_e_placed == NULL)
+		return ofs - data_anchor();
+	return e_placed_offset(ofs) - e_placed_offset(data_anchor());
+}
+
+/* lays out code and data of all objects into one executable, first object's code is the entry point */
+void e_link()
+{
+	int i;
+
+	e_link_members();
+
+	_e_code_idx = 0;
+	_e_data_idx = 0;
+	_e_symtab_idx = 0;
+	_e_strtab_idx = 0;
+	_e_symbol_idx = 0;
+	_e_header_idx = 0;
+	_e_footer_idx = 0;
+
+	e_place_sections(1);
+	while ((_e_code_idx & 3) > 0)
+		e_write_code_byte(0);
+	e_place_sections(2);
+	_e_bss_idx = _e_data_idx;
+	e_place_sections(3);
+
+	/* unit compiled for its place after clib must have got it */
+	if (_e_placed != NULL)
+		if (((_e_objects[1].places[1] != _e_placed_code) || (_e_objects[1].places[2] != _e_placed_data)) || (_e_objects[1].places[3] != _e_placed_bss))
+			error("Object not placed where it was compiled for");
+
+	for (i = 0; i < _e_objects_idx; i++)
+		e_define_symbols(&_e_objects[i]);
+	for (i = 0; i < _e_objects_idx; i++)
+		e_define_commons(&_e_objects[i]);
+	if (e_find_link_symbol("__global_pointer$") == NULL)
+		e_add_link_symbol("__global_pointer$", e_data_address() + 2048, 0);
+	for (i = 0; i < _e_objects_idx; i++)
+		e_apply_relocations(&_e_objects[i]);
+
+	e_add_symbol("", 0, 0); /* undef symbol */
+	for (i = 0; i < _e_link_symbols_idx; i++)
+		e_add_symbol(_e_link_symbols[i].name, strlen(_e_link_symbols[i].name), _e_link_symbols[i].value);
+
+	printf("Linked %d objects into %d code bytes and %d data bytes\n", _e_objects_idx, _e_code_idx, _e_data_idx);
+}
@@ -21,13 +21,38 @@ int _constants_idx;
 char *_source;
 int _source_idx;
 char _l_next_char;
+int _l_ifdef; /* inside an #ifdef block that was taken */
+int _l_conditional; /* source past _p_declare_end depends on #ifdef, so on the target */
 
 int _c_block_level;
+FILE *_c_listing; /* IL listing goes to stdout, or to the cache which then echoes it */
 int _p_break_level;
+int _p_reorder_fields; /* structs may place fields out of declaration order */
+int _p_start_code; /* binary entry point is generated, units of an object file have none */
+int _p_declare_end; /* source index before which definitions only declare, their code is in another object */
 int *_p_break_exit_il_idxs;
+literal_def *_p_literals; /* every literal and its suffixes */
+int _p_literals_idx;
+int *_p_literal_hash;
 
 variable_def *_temp_variable;
 
+/* IL optimizer */
+
+il_instr *_o_il; /* scratch IL while rebuilding */
+il_info_def *_o_info;
+value_def *_o_values;
+int _o_values_idx;
+int *_o_value_hash;
+loop_def *_o_loops;
+int _o_loops_idx;
+usage_def *_o_usage;
+int _o_usage_idx;
+il_instr *_o_hoisted; /* instructions to insert in loop preheaders */
+int *_o_hoisted_pos; /* IL index they are inserted before */
+int _o_hoisted_idx;
+sched_def *_o_sched; /* nodes of region being scheduled */
+
 backend_def *_backend;
 
 /* ELF sections */
@@ -36,6 +61,9 @@ char *_e_code;
 int _e_code_idx;
 char *_e_data;
 int _e_data_idx;
+char *_e_rodata; /* string literals, placed in the code segment after the instructions */
+int _e_rodata_idx;
+int _e_rodata_start; /* code offset of literals, known once code length is */
 char *_e_symtab;
 int _e_symtab_idx;
 char *_e_strtab;
@@ -47,6 +75,53 @@ int _e_footer_idx;
 int _e_header_len;
 int _e_code_start;
 int _e_symbol_idx;
+int *_e_relocs; /* data offsets holding a data offset, until data address is known */
+int _e_relocs_idx;
+int _e_bss_idx; /* data offset where zero-filled .bss starts */
+int _e_relocatable; /* generating an object file, addresses are left to the linker */
+reloc_def *_e_rela; /* relocations of code in an object file */
+int _e_rela_idx;
+object_def *_e_placed; /* precompiled clib the object is linked right after, NULL if where it goes is not known */
+int _e_placed_code; /* offsets of the object's code, .data and .bss once linked after it */
+int _e_placed_data;
+int _e_placed_bss;
+
+/* linker */
+
+object_def *_e_objects;
+int _e_objects_idx;
+object_def *_e_members; /* of archives, linked once something refers to what they define */
+int _e_members_idx;
+char *_e_clib; /* precompiled startup code and clib object */
+int _e_clib_idx;
+link_symbol_def *_e_link_symbols;
+int _e_link_symbols_idx;
+
+/* compilation cache */
+
+char *_k_dir; /* NULL unless caching */
+int _k_limit; /* bytes entries may take */
+int *_k_key;
+int _k_config; /* target and options, part of key */
+int _k_source_len; /* source bytes loaded, part of key */
+char *_k_listing; /* temporary listing file being written */
+
+void k_abandon();
+
+/* compile server */
+
+int _v_warm; /* set in a child serving a request */
+int _v_setup; /* target and options the server set up for */
+int _v_source_end; /* where the source of a request goes */
+char *_v_precompiled;
+int _v_jobs; /* batch units compiled at a time */
+int _v_running;
+int _v_units;
+int _v_failed;
+
+/* multi-target */
+
+int _m_failed; /* targets without output */
 
 type_def *find_type(char *type_name)
 {
@@ -62,6 +137,7 @@ il_instr *add_instr(il_op op)
 	il_instr *ii = &_il[_il_idx];
 	ii->op = op;
 	ii->op_len = 0;
+	ii->int_param2 = 0;
 	ii->string_param1 = 0;
 	ii->il_index = _il_idx++;
 	return ii;
@@ -84,22 +160,27 @@ block_def *add_block(block_def *parent, function_def *function)
 	bd->parent = parent;
 	bd->function = function;
 	bd->next_local = 0;
+	if (function == NULL)
+		bd->locals = malloc(MAX_GLOBALS * sizeof(variable_def));
+	else
+		bd->locals = malloc(MAX_LOCALS * sizeof(variable_def));
 	return bd;
 }
 
-void add_alias(char *alias, char *value)
+void add_alias(char *alias, char *value, int conditional)
 {
 	alias_def *al = &_aliases[_aliases_idx++];
 	strcpy(al->alias, alias);
 	strcpy(al->value, value);
+	al->conditional = conditional;
 }
 
-char *find_alias(char alias[])
+alias_def *find_alias(char alias[])
 {
 	int i;
 	for (i = 0; i < _aliases_idx; i++)
 		if (strcmp(alias, _aliases[i].alias) == 0)
-			return _aliases[i].value;
+			return &_aliases[i];
 	return NULL;
 }
 
@@ -115,6 +196,11 @@ function_def *add_function(char *name)
 
 	fn = &_functions[_functions_idx++];
 	strcpy(fn->return_def.variable_name, name);
+	fn->entry_point = -1;
+	fn->cache_regs = 0;
+	fn->saved_params = 0;
+	fn->link_offset = -1;
+	fn->pool_size = 0;
 	return fn;
 }
 
@@ -203,43 +289,91 @@ variable_def *find_variable(char *token, block_def *parent)
 	return var;
 }
 
+/* data offset where globals without initializer start, they take no space in the file */
+int bss_start()
+{
+	block_def *bd = &_blocks[0];
+	int i;
+
+	for (i = 0; i < bd->next_local; i++)
+		if (bd->locals[i].init == 0)
+			return bd->locals[i].offset;
+	return _e_data_idx;
+}
+
+/* data offset global register points to, globals within 2KB of it need no address calculation */
+int data_anchor()
+{
+	block_def *bd = &_blocks[0];
+
+	if (bd->next_local > 0)
+		return bss_start() + 2048;
+	return 2048;
+}
+
+/* alignment of variable's address */
+int align_variable(variable_def *var)
+{
+	type_def *td;
+
+	if ((var->is_pointer > 0) || (var->is_function > 0))
+		return PTR_SIZE;
+	td = find_type(var->type_name);
+	return td->align;
+}
+
+/* rounds offset up to a multiple of a power of two */
+int align_offset(int offset, int align)
+{
+	return (offset + (align - 1)) & (0 - align);
+}
+
 int size_variable(variable_def *var)
 {
 	type_def *td;
 	int bs, j, s = 0;
 
 	if (var->is_pointer > 0 || var->is_function > 0) {
-		s += 4;
+		bs = PTR_SIZE;
 	} else {
 		td = find_type(var->type_name);
 		bs = td->size;
-		if (var->array_size > 0) {
-			for (j = 0; j < var->array_size; j++)
-				s += bs;
-		} else
-			s += bs;
 	}
+	if (var->array_size > 0) {
+		for (j = 0; j < var->array_size; j++)
+			s += bs;
+	} else
+		s += bs;
 	return s;
 }
 
 void g_initialize()
 {
-	_e_header_len = 0x54; /* ELF fixed: 0x34 + 1 * 0x20 */
+	int i;
+
+	_e_header_len = 0x74; /* ELF fixed: 0x34 + 2 * 0x20 */
 
 	_e_header_idx = 0;
 	_e_footer_idx = 0;
 	_e_code_idx = 0;
 	_e_data_idx = 0;
+	_e_rodata_idx = 0;
+	_e_rodata_start = 0;
 	_il_idx = 0;
 	_source_idx = 0;
 	_e_strtab_idx = 0;
 	_e_symtab_idx = 0;
 	_aliases_idx = 0;
+	_l_ifdef = 0;
+	_l_conditional = 0;
 	_constants_idx = 0;
 	_blocks_idx = 0;
 	_types_idx = 0;
 	_functions_idx = 0;
 	_p_break_level = 0;
+	_p_reorder_fields = 0;
+	_p_start_code = 1;
+	_p_declare_end = 0;
 	_e_symbol_idx = 0;
 
 	_e_code_start = ELF_START + _e_header_len;
@@ -251,19 +385,56 @@ void g_initialize()
 	_source = malloc(MAX_SOURCE);
 	_e_code = malloc(MAX_CODE);
 	_e_data = malloc(MAX_DATA);
+	_e_rodata = malloc(MAX_DATA);
 	_e_symtab = malloc(MAX_SYMTAB);
 	_e_strtab = malloc(MAX_STRTAB);
 	_e_header = malloc(MAX_HEADER);
 	_e_footer = malloc(MAX_FOOTER);
+	_e_relocs = malloc(MAX_RELOCS * sizeof(int));
+	_e_relocs_idx = 0;
+	_e_bss_idx = 0;
+	_e_relocatable = 0;
+	_e_rela = malloc(MAX_RELA * sizeof(reloc_def));
+	_e_rela_idx = 0;
+	_e_placed = NULL;
+	_e_objects = malloc(MAX_OBJECTS * sizeof(object_def));
+	_e_objects_idx = 0;
+	_e_members = malloc(MAX_MEMBERS * sizeof(object_def));
+	_e_members_idx = 0;
+	_e_clib = malloc(MAX_CLIB);
+	_e_clib_idx = 0;
+	_e_link_symbols = malloc(MAX_LINK_SYMBOLS * sizeof(link_symbol_def));
+	_e_link_symbols_idx = 0;
+	_c_listing = stdout;
+	_k_dir = NULL;
+	_k_limit = K_DEFAULT_LIMIT;
+	_k_key = malloc(2 * sizeof(int));
+	_k_listing = NULL;
 	_aliases = malloc(MAX_ALIASES * sizeof(alias_def));
 	_constants = malloc(MAX_CONSTANTS * sizeof(constant_def));
 	_temp_variable = malloc(sizeof(variable_def));
 	_p_break_exit_il_idxs = malloc(MAX_NESTING * sizeof(int));
+	_p_literals = malloc(MAX_LITERALS * sizeof(literal_def));
+	_p_literal_hash = malloc(MAX_LITERAL_HASH * sizeof(int));
+	_p_literals_idx = 0;
+	for (i = 0; i < MAX_LITERAL_HASH; i++)
+		_p_literal_hash[i] = -1;
 	_backend = malloc(sizeof(backend_def));
+	_o_il = malloc(MAX_IL * sizeof(il_instr));
+	_o_info = malloc(MAX_IL * sizeof(il_info_def));
+	_o_values = malloc(MAX_VALUES * sizeof(value_def));
+	_o_value_hash = malloc(MAX_VALUE_HASH * sizeof(int));
+	_o_loops = malloc(MAX_LOOPS * sizeof(loop_def));
+	_o_usage = malloc(MAX_USAGE * sizeof(usage_def));
+	_o_hoisted = malloc(MAX_HOISTED * sizeof(il_instr));
+	_o_hoisted_pos = malloc(MAX_HOISTED * sizeof(int));
+	_o_sched = malloc(MAX_SCHEDULE * sizeof(sched_def));
 }
 
 void error(char *msg)
 {
+	k_abandon();
 	printf("Error %s at source location %d, IL index %d\n", msg, _source_idx, _il_idx);
+	fflush(stdout); /* may be a server's client */
 	abort();
 }
@@ -1,29 +1,41 @@
 /* rvcc C compiler - misc helpers */
 
-int is_whitespace(char c)
+/* ASCII character classes: 1 whitespace, 2 identifier, 4 decimal digit, 8 hex number */
+char _char_classes[128] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 0, 0, 0, 0, 0, 0,
+	0, 10, 10, 10, 10, 10, 10, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 2,
+	0, 10, 10, 10, 10, 10, 10, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 10, 2, 2, 0, 0, 0, 0, 0
+};
+
+int is_whitespace(int c)
 {
-	if (c == ' ' || c == '\r' || c == '\n' || c == '\t')
-		return 1;
-	return 0;
+	if (c < 0)
+		return 0;
+	return _char_classes[c] & 1;
 }
 
-int is_alnum(char c)
+int is_alnum(int c)
 {
-	if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || (c == '_'))
-		return 1;
-	return 0;
+	if (c < 0)
+		return 0;
+	return _char_classes[c] & 2;
 }
 
-int is_digit(char c)
+int is_digit(int c)
 {
-	if (c >= '0' && c <= '9')
-		return 1;
-	return 0;
+	if (c < 0)
+		return 0;
+	return _char_classes[c] & 4;
 }
 
-int is_hex(char c)
+int is_hex(int c)
 {
-	if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || c == 'x' || (c >= 'A' && c <= 'F'))
-		return 1;
-	return 0;
+	if (c < 0)
+		return 0;
+	return _char_classes[c] & 8;
 }
@@ -58,6 +58,7 @@ typedef enum {
 	t_sizeof,
 	t_elipsis,
 	t_asm,
+	t_extern,
 	t_switch,
 	t_case,
 	t_break,
@@ -123,9 +124,12 @@ l_token l_next_token()
 				_l_token_string[i++] = _l_next_char;
 			} while (l_read_char(0) != '\n');
 			_l_token_string[i] = 0;
+			if (_source_idx > _p_declare_end)
+				_l_conditional = 1;
 			/* check if we have this alias/define */
 			for (i = 0; i < _aliases_idx; i++) {
 				if (strcmp(_l_token_string, _aliases[i].alias) == 0) {
+					_l_ifdef = 1;
 					l_skip_whitespace();
 					return l_next_token();
 				}
@@ -143,6 +147,7 @@ l_token l_next_token()
 			return l_next_token();
 		}
 		if (strcmp(_l_token_string, "#endif") == 0) {
+			_l_ifdef = 0;
 			l_skip_whitespace();
 			return l_next_token();
 		}
@@ -392,7 +397,7 @@ l_token l_next_token()
 		return t_eof;
 	}
 	if (is_alnum(_l_next_char)) {
-		char *alias;
+		alias_def *alias;
 		int i = 0;
 		do {
 			_l_token_string[i++] = _l_next_char;
@@ -434,10 +439,14 @@ l_token l_next_token()
 			return t_include;
 		if (strcmp(_l_token_string, "_asm") == 0)
 			return t_asm;
+		if (strcmp(_l_token_string, "extern") == 0)
+			return t_extern;
 
 		alias = find_alias(_l_token_string);
 		if (alias != NULL) {
-			strcpy(_l_token_string, alias);
+			if (alias->conditional && (_source_idx > _p_declare_end))
+				_l_conditional = 1;
+			strcpy(_l_token_string, alias->value);
 			return t_numeric;
 		}
 
@@ -486,5 +495,15 @@ void l_initialize()
 {
 	_source_idx = 0;
 	_l_next_char = _source[0];
+	_l_next_token = t_sof; /* may have lexed to the end of an earlier parse */
 	l_expect(t_sof);
 }
+
+/* goes on lexing from pos, after source lexed to its end got more of it there */
+void l_resume(int pos)
+{
+	_source_idx = pos;
+	_l_next_char = _source[pos];
+	l_skip_whitespace();
+	_l_next_token = l_next_token();
+}
@@ -0,0 +1,1608 @@
+/* rvcc C compiler - IL optimizer */
+
+/* IL instruction analysis flags */
+#define OF_DEAD 1
+#define OF_TARGET 2
+#define OF_MAXIMAL 4
+#define OF_STOP 8
+#define OF_KEEP 16
+
+/* registers 0..7 are parameters, 8.. are callee-saved cache registers */
+#define PARAM_REGS_MASK 255
+
+int _o_regs[MAX_REGS];
+int _o_def_of[MAX_REGS];
+int _o_cached[MAX_REGS];
+int _o_stack[MAX_NESTING];
+int _o_stack_idx;
+block_def *_o_block;
+function_def *_o_fn;
+int _o_param_escape;
+int _o_mem; /* memory version for reads through unknown pointers */
+
+int o_is_binary(il_op op)
+{
+	if (op >= op_add && op <= op_bit_and && op != op_not)
+		return 1;
+	return 0;
+}
+
+int o_is_commutative(il_op op)
+{
+	switch (op) {
+	case op_add:
+	case op_mul:
+	case op_log_and:
+	case op_log_or:
+	case op_equals:
+	case op_not_equals:
+	case op_bit_or:
+	case op_bit_and:
+		return 1;
+	default:
+		return 0;
+	}
+	return 0;
+}
+
+/* instruction only computes a value into its destination register */
+int o_is_pure(il_op op)
+{
+	switch (op) {
+	case op_load_numeric_constant:
+	case op_load_data_address:
+	case op_get_var_addr:
+	case op_read_addr:
+	case op_move:
+	case op_not:
+	case op_negate:
+		return 1;
+	default:
+		return o_is_binary(op);
+	}
+	return 0;
+}
+
+int o_is_call(il_op op)
+{
+	if (op == op_function_call || op == op_tail_call || op == op_pointer_call || op == op_syscall)
+		return 1;
+	return 0;
+}
+
+int o_is_jump(il_op op)
+{
+	if (op == op_jump || op == op_jz || op == op_jnz)
+		return 1;
+	return 0;
+}
+
+/* registers read by an instruction */
+int o_use(il_instr *ii)
+{
+	switch (ii->op) {
+	case op_read_addr:
+	case op_move:
+		return 1 << ii->int_param1;
+	case op_write_addr:
+		return (1 << ii->param_no) | (1 << ii->int_param1);
+	case op_jz:
+	case op_jnz:
+	case op_push:
+	case op_not:
+	case op_negate:
+		return 1 << ii->param_no;
+	case op_return:
+	case op_exit_point:
+		return 1;
+	case op_function_call:
+	case op_tail_call:
+	case op_syscall:
+		return (1 << ii->int_param1) - 1;
+	case op_pointer_call:
+	case op_generic:
+		return PARAM_REGS_MASK;
+	default:
+		if (o_is_binary(ii->op))
+			return (1 << ii->param_no) | (1 << ii->int_param1);
+		return 0;
+	}
+	return 0;
+}
+
+/* registers written by an instruction */
+int o_def(il_instr *ii)
+{
+	switch (ii->op) {
+	case op_function_call:
+	case op_tail_call:
+	case op_pointer_call:
+	case op_syscall:
+		return PARAM_REGS_MASK;
+	case op_start:
+		return 3;
+	case op_pop:
+		return 1 << ii->param_no;
+	default:
+		if (o_is_pure(ii->op))
+			return 1 << ii->param_no;
+		return 0;
+	}
+	return 0;
+}
+
+/* jump destination of an instruction, -1 if it only falls through */
+int o_jump_target(il_instr *ii)
+{
+	if (o_is_jump(ii->op))
+		return ii->int_param1;
+	if (ii->op == op_return)
+		return _o_fn->exit_point;
+	return -1;
+}
+
+/* refreshes registers used by instruction i after it changed */
+void o_update(int i)
+{
+	_o_info[i].uses = 0;
+	_o_info[i].defs = 0;
+	if ((_o_info[i].flags & OF_DEAD) == 0) {
+		_o_info[i].uses = o_use(&_il[i]);
+		_o_info[i].defs = o_def(&_il[i]);
+	}
+}
+
+/* computes registers live before and after each instruction of function in [s, e] */
+void o_liveness(int s, int e)
+{
+	il_info_def *info;
+	int i, in, out, changed = 1;
+
+	for (i = s; i <= e; i++)
+		_o_info[i].live_in = 0;
+
+	while (changed) {
+		changed = 0;
+		for (i = e; i >= s; i--) {
+			info = &_o_info[i];
+			out = 0;
+			if ((info->flags & OF_STOP) == 0 && i < e)
+				out = _o_info[i + 1].live_in;
+			if (info->target >= 0)
+				out |= _o_info[info->target].live_in;
+			in = info->uses | (out - (out & info->defs));
+			if (in != info->live_in) {
+				info->live_in = in;
+				changed = 1;
+			}
+			info->live = out;
+		}
+	}
+}
+
+/* is instruction at i the last one of its basic block */
+int o_ends_block(int i, int e)
+{
+	if (i == e)
+		return 1;
+	if (_o_info[i].target >= 0)
+		return 1;
+	if (_o_info[i + 1].flags & OF_TARGET)
+		return 1;
+	return 0;
+}
+
+/* finds basic block boundaries of function in [s, e] */
+void o_mark_blocks(int s, int e)
+{
+	int i, t;
+	il_op op;
+
+	for (i = s; i <= e; i++) {
+		op = _il[i].op;
+		t = o_jump_target(&_il[i]);
+		_o_info[i].target = t;
+		if (t >= 0)
+			_o_info[t].flags |= OF_TARGET;
+		if (op == op_jump || op == op_return || op == op_tail_call || op == op_exit_point)
+			_o_info[i].flags |= OF_STOP;
+		o_update(i);
+	}
+}
+
+int o_is_global(variable_def *var)
+{
+	block_def *bd = &_blocks[0];
+	int i;
+
+	for (i = 0; i < bd->next_local; i++)
+		if (&bd->locals[i] == var)
+			return 1;
+	return 0;
+}
+
+int o_is_param(variable_def *var)
+{
+	int i;
+
+	for (i = 0; i < _o_fn->num_params; i++)
+		if (&_o_fn->param_defs[i] == var)
+			return 1;
+	return 0;
+}
+
+/* resolve variable the same way code generator does */
+variable_def *o_resolve(char *name, block_def *bd)
+{
+	variable_def *var = find_global_variable(name);
+	if (var == NULL)
+		if (bd != NULL)
+			var = find_local_variable(name, bd);
+	return var;
+}
+
+usage_def *o_usage(variable_def *var)
+{
+	usage_def *u;
+	int i;
+
+	for (i = 0; i < _o_usage_idx; i++)
+		if (_o_usage[i].var == var)
+			return &_o_usage[i];
+
+	if (_o_usage_idx >= MAX_USAGE)
+		error("Too many variables to optimize");
+	u = &_o_usage[_o_usage_idx++];
+	u->var = var;
+	u->global = o_is_global(var);
+	u->escapes = u->global;
+	u->stored = 0;
+	u->version = 0;
+	return u;
+}
+
+/* can memory of this variable be reached other than through its name */
+int o_escapes(usage_def *u)
+{
+	if (u->escapes)
+		return 1;
+	if (_o_param_escape)
+		return o_is_param(u->var);
+	return 0;
+}
+
+int o_same_name(char *n1, char *n2)
+{
+	if (n1 == NULL || n2 == NULL)
+		return n1 == n2;
+	return strcmp(n1, n2) == 0;
+}
+
+int o_new_value(il_op op, int v1, int v2, int mem, variable_def *var, char *name)
+{
+	value_def *val;
+
+	if (_o_values_idx >= MAX_VALUES)
+		error("Too many values to optimize");
+
+	val = &_o_values[_o_values_idx];
+	val->op = op;
+	val->v1 = v1;
+	val->v2 = v2;
+	val->mem = mem;
+	val->var = var;
+	val->name = name;
+	val->base = NULL;
+	val->direct = 0;
+	val->cost = 1;
+	val->weight = 0;
+	val->seen = -1;
+	val->next = -1;
+	_o_values[_o_values_idx].invariant = -1;
+	return _o_values_idx++;
+}
+
+int o_unknown()
+{
+	return o_new_value(op_generic, 0, 0, 0, NULL, NULL);
+}
+
+/* address base and cost of a new value */
+void o_describe_value(value_def *val)
+{
+	value_def *a;
+	value_def *b;
+
+	switch (val->op) {
+	case op_load_numeric_constant:
+		if (val->v1 < -2048 || val->v1 > 2046)
+			val->cost = 2;
+		break;
+	case op_load_data_address:
+		val->cost = 2;
+		break;
+	case op_get_var_addr:
+		val->cost = 2;
+		if (val->var != NULL) {
+			val->base = o_usage(val->var);
+			val->direct = 1;
+		}
+		break;
+	case op_read_addr:
+	case op_not:
+	case op_negate:
+		val->cost = _o_values[val->v1].cost + 1;
+		break;
+	default:
+		a = &_o_values[val->v1];
+		b = &_o_values[val->v2];
+		val->cost = a->cost + b->cost + 1;
+		if (val->op == op_add || val->op == op_sub) {
+			if (b->base == NULL) {
+				val->base = a->base;
+				if (b->op == op_load_numeric_constant)
+					val->direct = a->direct;
+			} else if (a->base == NULL) {
+				if (val->op == op_add) {
+					val->base = b->base;
+					if (a->op == op_load_numeric_constant)
+						val->direct = b->direct;
+				}
+			}
+		}
+		break;
+	}
+	if (val->cost > 64)
+		val->cost = 64;
+}
+
+/* finds or creates value number of an operation */
+int o_value(il_op op, int v1, int v2, int mem, variable_def *var, char *name)
+{
+	value_def *val;
+	int h, i;
+
+	if (o_is_commutative(op))
+		if (v1 > v2) {
+			h = v1;
+			v1 = v2;
+			v2 = h;
+		}
+
+	h = (op * 7) + ((v1 & 65535) * 31) + ((v2 & 65535) * 131);
+	if (name != NULL)
+		h += name[0] + (name[1] * 17);
+	h = h & (MAX_VALUE_HASH - 1);
+
+	i = _o_value_hash[h];
+	while (i >= 0) {
+		val = &_o_values[i];
+		if (val->op == op && val->v1 == v1 && val->v2 == v2 && val->mem == mem && val->var == var)
+			if (o_same_name(val->name, name))
+				return i;
+		i = val->next;
+	}
+
+	i = o_new_value(op, v1, v2, mem, var, name);
+	val = &_o_values[i];
+	val->next = _o_value_hash[h];
+	_o_value_hash[h] = i;
+	o_describe_value(val);
+	return i;
+}
+
+void o_reset_values()
+{
+	int i;
+
+	_o_values_idx = 0;
+	for (i = 0; i < MAX_VALUE_HASH; i++)
+		_o_value_hash[i] = -1;
+}
+
+/* forget register contents at start of a basic block */
+void o_reset_regs()
+{
+	int r;
+
+	for (r = 0; r < MAX_REGS; r++) {
+		if (_o_cached[r] >= 0)
+			_o_regs[r] = _o_cached[r];
+		else
+			_o_regs[r] = o_unknown();
+		_o_def_of[r] = -1;
+	}
+	_o_stack_idx = 0;
+}
+
+/* memory reachable through pointers may have changed */
+void o_clobber()
+{
+	int i;
+
+	_o_mem++;
+	for (i = 0; i < _o_usage_idx; i++)
+		if (o_escapes(&_o_usage[i]))
+			_o_usage[i].version++;
+}
+
+/* memory at address value v changed */
+void o_store(int v)
+{
+	usage_def *u = _o_values[v].base;
+
+	if (u == NULL)
+		o_clobber();
+	else {
+		u->version++;
+		if (o_escapes(u))
+			_o_mem++;
+	}
+}
+
+/* evaluates instruction i on simulated registers, records its value */
+void o_step(int i)
+{
+	il_instr *ii = &_il[i];
+	value_def *addr;
+	int v = -1, r, mem;
+
+	switch (ii->op) {
+	case op_load_numeric_constant:
+	case op_load_data_address:
+		v = o_value(ii->op, ii->int_param1, 0, 0, NULL, NULL);
+		break;
+	case op_get_var_addr:
+		/* resolved once per function */
+		v = _o_info[i].vn;
+		if (v < 0)
+			v = o_value(op_get_var_addr, 0, 0, 0, o_resolve(ii->string_param1, _o_block), ii->string_param1);
+		break;
+	case op_read_addr:
+		/* reads are only equal while no store may have changed memory */
+		addr = &_o_values[_o_regs[ii->int_param1]];
+		if (addr->base != NULL)
+			mem = addr->base->version;
+		else
+			mem = _o_mem;
+		v = o_value(op_read_addr, _o_regs[ii->int_param1], ii->int_param2, mem, NULL, NULL);
+		break;
+	case op_write_addr:
+		o_store(_o_regs[ii->int_param1]);
+		break;
+	case op_move:
+		v = _o_regs[ii->int_param1];
+		break;
+	case op_not:
+	case op_negate:
+		v = o_value(ii->op, _o_regs[ii->param_no], 0, 0, NULL, NULL);
+		break;
+	case op_push:
+		if (_o_stack_idx < MAX_NESTING)
+			_o_stack[_o_stack_idx] = _o_regs[ii->param_no];
+		_o_stack_idx++;
+		break;
+	case op_pop:
+		_o_stack_idx--;
+		if (_o_stack_idx >= 0 && _o_stack_idx < MAX_NESTING)
+			v = _o_stack[_o_stack_idx];
+		else
+			v = o_unknown();
+		if (_o_stack_idx < 0)
+			_o_stack_idx = 0;
+		break;
+	case op_block_start:
+		_o_block = &_blocks[ii->int_param1];
+		break;
+	case op_block_end:
+		_o_block = _blocks[ii->int_param1].parent;
+		break;
+	case op_function_call:
+	case op_tail_call:
+	case op_pointer_call:
+	case op_syscall:
+	case op_start:
+		for (r = 0; r < MAX_PARAMS; r++)
+			_o_regs[r] = o_unknown();
+		o_clobber();
+		break;
+	default:
+		if (o_is_binary(ii->op))
+			v = o_value(ii->op, _o_regs[ii->param_no], _o_regs[ii->int_param1], 0, NULL, NULL);
+		break;
+	}
+	if (v >= 0)
+		_o_regs[ii->param_no] = v;
+	_o_info[i].vn = v;
+}
+
+block_def *o_block_at(int s, int i)
+{
+	block_def *bd = NULL;
+
+	while (s < i) {
+		if (_il[s].op == op_block_start)
+			bd = &_blocks[_il[s].int_param1];
+		else if (_il[s].op == op_block_end)
+			bd = _blocks[_il[s].int_param1].parent;
+		s++;
+	}
+	return bd;
+}
+
+void o_escape_value(int v)
+{
+	usage_def *u = _o_values[v].base;
+
+	if (u != NULL) {
+		u->escapes = 1;
+		if (o_is_param(u->var))
+			_o_param_escape = 1;
+	}
+}
+
+/* find locals whose address leaves the IL reads and writes */
+void o_find_escapes(int s, int e)
+{
+	int i, r;
+
+	_o_param_escape = 0;
+	_o_block = NULL;
+	for (i = s; i <= e; i++) {
+		il_instr *ii = &_il[i];
+
+		if (i == s || (_o_info[i].flags & OF_TARGET))
+			o_reset_regs();
+
+		if (ii->op == op_write_addr || ii->op == op_push)
+			o_escape_value(_o_regs[ii->param_no]);
+		else if (ii->op == op_return || ii->op == op_exit_point)
+			o_escape_value(_o_regs[0]);
+		else if (o_is_call(ii->op)) {
+			for (r = 0; r < MAX_PARAMS; r++)
+				if (_o_info[i].uses & (1 << r))
+					o_escape_value(_o_regs[r]);
+		}
+
+		o_step(i);
+
+		if (o_ends_block(i, e))
+			for (r = 0; r < MAX_REGS; r++)
+				if (_o_info[i].live & (1 << r))
+					o_escape_value(_o_regs[r]);
+	}
+}
+
+/* finds natural loops as ranges from header to last backward jump */
+void o_find_loops(int s, int e)
+{
+	int i, j, t, found, changed;
+	loop_def *l1;
+	loop_def *l2;
+	loop_def tmp;
+
+	_o_loops_idx = 0;
+	for (i = s; i <= e; i++) {
+		if (o_is_jump(_il[i].op)) {
+			t = _il[i].int_param1;
+			if (t <= i && t >= s) {
+				found = 0;
+				for (j = 0; j < _o_loops_idx; j++)
+					if (_o_loops[j].start == t) {
+						_o_loops[j].end = i;
+						found = 1;
+					}
+				if (found == 0 && _o_loops_idx < MAX_LOOPS) {
+					_o_loops[_o_loops_idx].start = t;
+					_o_loops[_o_loops_idx].end = i;
+					_o_loops[_o_loops_idx].cache_mask = 0;
+					_o_loops_idx++;
+				}
+			}
+		}
+	}
+
+	/* merge partially overlapping ranges, i.e. for loop increments */
+	changed = 1;
+	while (changed) {
+		changed = 0;
+		for (i = 0; i < _o_loops_idx; i++)
+			for (j = 0; j < _o_loops_idx; j++) {
+				l1 = &_o_loops[i];
+				l2 = &_o_loops[j];
+				if (l1->start >= 0 && l2->start >= 0 && i != j)
+					if (l1->start <= l2->start && l2->start <= l1->end && l1->end < l2->end) {
+						l1->end = l2->end;
+						if (l1->start == l2->start)
+							l2->start = -1;
+						changed = 1;
+					}
+			}
+	}
+
+	/* a loop must only be entered through its header */
+	for (i = s; i <= e; i++) {
+		t = _o_info[i].target;
+		if (t >= 0)
+			for (j = 0; j < _o_loops_idx; j++) {
+				l1 = &_o_loops[j];
+				if (t >= l1->start && t <= l1->end && (i < l1->start || i > l1->end))
+					l1->start = -1;
+			}
+	}
+
+	/* drop invalid loops and order by header */
+	j = 0;
+	for (i = 0; i < _o_loops_idx; i++)
+		if (_o_loops[i].start >= 0)
+			memcpy(&_o_loops[j++], &_o_loops[i], sizeof(loop_def));
+	_o_loops_idx = j;
+	for (i = 1; i < _o_loops_idx; i++)
+		for (j = i; j > 0; j--)
+			if (_o_loops[j - 1].start > _o_loops[j].start) {
+				memcpy(&tmp, &_o_loops[j], sizeof(loop_def));
+				memcpy(&_o_loops[j], &_o_loops[j - 1], sizeof(loop_def));
+				memcpy(&_o_loops[j - 1], &tmp, sizeof(loop_def));
+			}
+}
+
+/* is value the same on every iteration of loop being optimized */
+int o_is_invariant(int v, loop_def *loop)
+{
+	value_def *val = &_o_values[v];
+	value_def *addr;
+	usage_def *u;
+	int inv = 0;
+
+	if (_o_values[v].invariant >= 0)
+		return _o_values[v].invariant;
+
+	switch (val->op) {
+	case op_load_numeric_constant:
+	case op_load_data_address:
+		inv = 1;
+		break;
+	case op_get_var_addr:
+		if (val->var == NULL)
+			inv = 1;
+		else {
+			/* locals must be in scope ahead of loop */
+			u = val->base;
+			if (u->global)
+				inv = 1;
+			else if (find_local_variable(val->name, loop->block) == val->var)
+				inv = 1;
+		}
+		break;
+	case op_read_addr:
+		/* only reads of variables are safe to move ahead of loop */
+		addr = &_o_values[val->v1];
+		if (addr->direct)
+			if (o_is_invariant(val->v1, loop)) {
+				u = addr->base;
+				if (u->stored == 0) {
+					if (o_escapes(u) == 0)
+						inv = 1;
+					else if (loop->calls == 0 && loop->stores == 0)
+						inv = 1;
+				}
+			}
+		break;
+	case op_not:
+	case op_negate:
+		inv = o_is_invariant(val->v1, loop);
+		break;
+	case op_generic:
+		break;
+	default:
+		if (o_is_invariant(val->v1, loop))
+			inv = o_is_invariant(val->v2, loop);
+		break;
+	}
+	_o_values[v].invariant = inv;
+	return inv;
+}
+
+int o_cached_reg(int v)
+{
+	int r;
+
+	for (r = MAX_PARAMS; r < MAX_REGS; r++)
+		if (_o_cached[r] == v)
+			return r;
+	return -1;
+}
+
+/* scratch registers needed to compute a value */
+int o_scratch_needed(int v)
+{
+	value_def *val = &_o_values[v];
+	int n1, n2;
+
+	if (o_cached_reg(v) >= 0)
+		return 0;
+	switch (val->op) {
+	case op_read_addr:
+	case op_not:
+	case op_negate:
+		return o_scratch_needed(val->v1);
+	default:
+		if (o_is_binary(val->op)) {
+			n1 = o_scratch_needed(val->v1);
+			n2 = 0;
+			if (o_cached_reg(val->v2) < 0)
+				n2 = o_scratch_needed(val->v2) + 1;
+			if (n1 > n2)
+				return n1;
+			return n2;
+		}
+		return 0;
+	}
+	return 0;
+}
+
+il_instr *o_hoist(il_op op, int reg, int pos)
+{
+	il_instr *ii;
+
+	if (_o_hoisted_idx >= MAX_HOISTED)
+		error("Too many hoisted instructions");
+	ii = &_o_hoisted[_o_hoisted_idx];
+	_o_hoisted_pos[_o_hoisted_idx++] = pos;
+	ii->op = op;
+	ii->op_len = 0;
+	ii->param_no = reg;
+	ii->int_param1 = 0;
+	ii->int_param2 = 0;
+	ii->string_param1 = NULL;
+	return ii;
+}
+
+/* emits instructions computing value into reg, placed before IL index pos */
+void o_emit_value(int v, int reg, int scratch, int pos)
+{
+	value_def *val = &_o_values[v];
+	il_instr *ii;
+	int r = o_cached_reg(v), t;
+
+	if (r >= 0) {
+		ii = o_hoist(op_move, reg, pos);
+		ii->int_param1 = r;
+		return;
+	}
+
+	switch (val->op) {
+	case op_load_numeric_constant:
+	case op_load_data_address:
+		ii = o_hoist(val->op, reg, pos);
+		ii->int_param1 = val->v1;
+		break;
+	case op_get_var_addr:
+		ii = o_hoist(op_get_var_addr, reg, pos);
+		ii->string_param1 = val->name;
+		break;
+	case op_read_addr:
+		o_emit_value(val->v1, reg, scratch, pos);
+		ii = o_hoist(op_read_addr, reg, pos);
+		ii->int_param1 = reg;
+		ii->int_param2 = val->v2;
+		break;
+	case op_not:
+	case op_negate:
+		o_emit_value(val->v1, reg, scratch, pos);
+		o_hoist(val->op, reg, pos);
+		break;
+	default:
+		o_emit_value(val->v1, reg, scratch, pos);
+		r = o_cached_reg(val->v2);
+		if (r < 0) {
+			/* lowest free scratch register */
+			t = 0;
+			while ((scratch & (1 << t)) == 0)
+				t++;
+			o_emit_value(val->v2, t, scratch - (1 << t), pos);
+			r = t;
+		}
+		ii = o_hoist(val->op, reg, pos);
+		ii->int_param1 = r;
+		break;
+	}
+}
+
+int o_count_bits(int mask)
+{
+	int n = 0;
+
+	while (mask != 0) {
+		if (mask & 1)
+			n++;
+		mask = mask >> 1;
+	}
+	return n;
+}
+
+/* simulates loop body, calls visit for every instruction */
+void o_scan_loop(loop_def *loop, int e, int mark)
+{
+	int i, r, v, inv;
+	il_instr *ii;
+	usage_def *u;
+
+	_o_block = loop->block;
+	for (i = loop->start; i <= loop->end; i++) {
+		ii = &_il[i];
+
+		if (i == loop->start || (_o_info[i].flags & OF_TARGET))
+			o_reset_regs();
+
+		if (mark == 0) {
+			/* collect side effects */
+			if (ii->op == op_write_addr) {
+				v = _o_regs[ii->int_param1];
+				u = _o_values[v].base;
+				if (u != NULL) {
+					u->stored = 1;
+				} else
+					loop->stores = 1;
+			} else if (o_is_call(ii->op) || ii->op == op_generic)
+				loop->calls = 1;
+			o_step(i);
+		} else {
+			/* find largest invariant expressions */
+			int use = o_use(ii);
+
+			o_step(i);
+			inv = 0;
+			if (o_is_pure(ii->op))
+				inv = o_is_invariant(_o_info[i].vn, loop);
+			for (r = 0; r < MAX_REGS; r++)
+				if (use & (1 << r))
+					if (_o_def_of[r] >= 0 && inv == 0)
+						_o_info[_o_def_of[r]].flags |= OF_MAXIMAL;
+			if (inv) {
+				if (ii->op == op_move)
+					_o_def_of[ii->param_no] = -1;
+				else
+					_o_def_of[ii->param_no] = i;
+			} else {
+				for (r = 0; r < MAX_REGS; r++)
+					if (o_def(ii) & (1 << r))
+						_o_def_of[r] = -1;
+			}
+			if (o_ends_block(i, e))
+				for (r = 0; r < MAX_REGS; r++)
+					if (_o_def_of[r] >= 0 && (_o_info[i].live & (1 << r)) != 0)
+						_o_info[_o_def_of[r]].flags |= OF_MAXIMAL;
+		}
+	}
+}
+
+void o_hoist_loop(int s, int e, loop_def *loop)
+{
+	int i, r, v, best, best_weight, busy, scratch, avail, done;
+	value_def *val;
+	loop_def *outer;
+
+	/* cache registers of enclosing loops keep their values */
+	busy = 0;
+	for (r = 0; r < MAX_REGS; r++)
+		_o_cached[r] = -1;
+	for (i = 0; i < _o_loops_idx; i++) {
+		outer = &_o_loops[i];
+		if (outer != loop && outer->start <= loop->start && outer->end >= loop->end) {
+			busy |= outer->cache_mask;
+			for (r = MAX_PARAMS; r < MAX_REGS; r++)
+				if (outer->cache_mask & (1 << r))
+					_o_cached[r] = outer->cache_values[r];
+		}
+	}
+
+	loop->block = o_block_at(s, loop->start);
+	loop->calls = 0;
+	loop->stores = 0;
+	for (i = 0; i < _o_usage_idx; i++)
+		_o_usage[i].stored = 0;
+	for (i = 0; i < _o_values_idx; i++)
+		_o_values[i].invariant = -1;
+	for (r = MAX_PARAMS; r < MAX_REGS; r++)
+		if (_o_cached[r] >= 0)
+			_o_values[_o_cached[r]].invariant = 1;
+	for (i = loop->start; i <= loop->end; i++)
+		_o_info[i].flags -= _o_info[i].flags & OF_MAXIMAL;
+
+	o_scan_loop(loop, e, 0);
+	o_scan_loop(loop, e, 1);
+
+	avail = 0;
+	for (r = MAX_PARAMS; r < MAX_PARAMS + _backend->cache_regs; r++)
+		if ((busy & (1 << r)) == 0)
+			avail++;
+
+	/* instructions saved per iteration by keeping value in register */
+	for (i = loop->start; i <= loop->end; i++)
+		if (_o_info[i].flags & OF_MAXIMAL)
+			_o_values[_o_info[i].vn].weight = 0;
+	for (i = loop->start; i <= loop->end; i++)
+		if (_o_info[i].flags & OF_MAXIMAL) {
+			val = &_o_values[_o_info[i].vn];
+			if (val->cost >= 2 && o_cached_reg(_o_info[i].vn) < 0)
+				val->weight += val->cost;
+		}
+
+	/* pick expressions saving most */
+	done = 0;
+	while (done < avail) {
+		best = -1;
+		best_weight = 0;
+		for (i = loop->start; i <= loop->end; i++)
+			if (_o_info[i].flags & OF_MAXIMAL) {
+				v = _o_info[i].vn;
+				if (_o_values[v].weight > best_weight) {
+					best_weight = _o_values[v].weight;
+					best = v;
+				}
+			}
+		if (best < 0)
+			done = avail;
+		else {
+			scratch = PARAM_REGS_MASK - (_o_info[loop->start].live_in & PARAM_REGS_MASK);
+			if (o_scratch_needed(best) > o_count_bits(scratch)) {
+				/* no registers to compute it ahead of loop */
+				_o_values[best].weight = 0;
+			} else {
+				r = MAX_PARAMS;
+				while (busy & (1 << r))
+					r++;
+				o_emit_value(best, r, scratch, loop->start);
+				_o_values[best].weight = 0;
+				busy |= 1 << r;
+				_o_cached[r] = best;
+				loop->cache_mask |= 1 << r;
+				loop->cache_values[r] = best;
+				if (r - MAX_PARAMS + 1 > _o_fn->cache_regs)
+					_o_fn->cache_regs = r - MAX_PARAMS + 1;
+				done++;
+			}
+		}
+	}
+
+	/* computations inside the loop become register copies */
+	for (i = loop->start; i <= loop->end; i++)
+		if (_o_info[i].flags & OF_MAXIMAL) {
+			r = o_cached_reg(_o_info[i].vn);
+			if (r >= MAX_PARAMS) {
+				_il[i].op = op_move;
+				_il[i].int_param1 = r;
+				o_update(i);
+			}
+		}
+}
+
+void o_hoist_function(int s, int e)
+{
+	int i;
+
+	o_find_loops(s, e);
+	for (i = 0; i < _o_loops_idx; i++)
+		o_hoist_loop(s, e, &_o_loops[i]);
+}
+
+/* reuses values computed earlier in [rs, re], which is only entered at rs */
+void o_cse_region(int e, int rs, int re)
+{
+	int i, r, v, use, red, busy, best, best_weight, need, more, inner = 0;
+	il_instr *ii;
+	value_def *val;
+	loop_def *loop;
+
+	/* keep away from cache registers of loops around region */
+	busy = 0;
+	for (r = 0; r < MAX_REGS; r++)
+		_o_cached[r] = -1;
+	for (i = 0; i < _o_loops_idx; i++) {
+		loop = &_o_loops[i];
+		if (loop->start <= re && loop->end >= rs) {
+			busy |= loop->cache_mask;
+			if (loop->start <= rs && loop->end >= re) {
+				inner = 1;
+				for (r = MAX_PARAMS; r < MAX_REGS; r++)
+					if (loop->cache_mask & (1 << r))
+						_o_cached[r] = loop->cache_values[r];
+			}
+		}
+	}
+
+	/* find recomputed values that are used as a whole */
+	o_reset_regs();
+	for (i = rs; i <= re; i++) {
+		ii = &_il[i];
+		use = _o_info[i].uses;
+		_o_info[i].flags -= _o_info[i].flags & OF_MAXIMAL;
+
+		o_step(i);
+		red = 0;
+		if (o_is_pure(ii->op) && ii->op != op_move) {
+			val = &_o_values[_o_info[i].vn];
+			if (val->seen >= rs)
+				red = 1;
+			else
+				val->seen = i;
+		}
+		for (r = 0; r < MAX_REGS; r++)
+			if (use & (1 << r))
+				if (_o_def_of[r] >= 0 && red == 0)
+					_o_info[_o_def_of[r]].flags |= OF_MAXIMAL;
+		if (red)
+			_o_def_of[ii->param_no] = i;
+		else {
+			for (r = 0; r < MAX_REGS; r++)
+				if (_o_info[i].defs & (1 << r))
+					_o_def_of[r] = -1;
+		}
+		if (o_ends_block(i, e))
+			for (r = 0; r < MAX_REGS; r++)
+				if (_o_def_of[r] >= 0 && (_o_info[i].live & (1 << r)) != 0)
+					_o_info[_o_def_of[r]].flags |= OF_MAXIMAL;
+	}
+
+	/* instructions saved by keeping first result in register */
+	for (i = rs; i <= re; i++)
+		if (_o_info[i].flags & OF_MAXIMAL)
+			_o_values[_o_info[i].vn].weight = 0;
+	for (i = rs; i <= re; i++)
+		if (_o_info[i].flags & OF_MAXIMAL) {
+			val = &_o_values[_o_info[i].vn];
+			if (val->cost >= 2 && o_cached_reg(_o_info[i].vn) < 0)
+				val->weight += val->cost - 1;
+		}
+
+	more = 1;
+	while (more) {
+		best = -1;
+		best_weight = 0;
+		for (i = rs; i <= re; i++)
+			if (_o_info[i].flags & OF_MAXIMAL) {
+				v = _o_info[i].vn;
+				if (_o_values[v].weight > best_weight) {
+					best_weight = _o_values[v].weight;
+					best = v;
+				}
+			}
+		r = MAX_PARAMS;
+		while (r < MAX_PARAMS + _backend->cache_regs && (busy & (1 << r)) != 0)
+			r++;
+		if (best < 0 || r == MAX_PARAMS + _backend->cache_regs)
+			more = 0;
+		else {
+			/* a register not used yet also needs saving in prologue */
+			need = 1;
+			if (r >= MAX_PARAMS + _o_fn->cache_regs && inner == 0)
+				need = 3;
+			if (best_weight > need) {
+				val = &_o_values[best];
+				ii = o_hoist(op_move, r, val->seen + 1);
+				ii->int_param1 = _il[val->seen].param_no;
+				_o_info[val->seen].flags |= OF_KEEP;
+				busy |= 1 << r;
+				_o_cached[r] = best;
+				if (r - MAX_PARAMS + 1 > _o_fn->cache_regs)
+					_o_fn->cache_regs = r - MAX_PARAMS + 1;
+			}
+			_o_values[best].weight = 0;
+		}
+	}
+
+	/* recomputations become register copies */
+	for (i = rs; i <= re; i++)
+		if (_o_info[i].flags & OF_MAXIMAL) {
+			r = o_cached_reg(_o_info[i].vn);
+			if (r >= MAX_PARAMS) {
+				_il[i].op = op_move;
+				_il[i].int_param1 = r;
+				o_update(i);
+			}
+		}
+}
+
+/* common subexpression elimination over code entered only at its top */
+void o_cse_function(int s, int e)
+{
+	int i, rs = s;
+
+	_o_block = NULL;
+	for (i = s; i <= e; i++)
+		if (i == e || (_o_info[i + 1].flags & OF_TARGET) != 0) {
+			o_cse_region(e, rs, i);
+			rs = i + 1;
+		}
+}
+
+/* replaces register copies with their source where possible */
+void o_propagate(int s, int e)
+{
+	il_instr *ii;
+	il_instr *next;
+	int i, k, d, c, stop;
+
+	for (i = s; i <= e; i++) {
+		ii = &_il[i];
+		if (ii->op == op_move) {
+			d = ii->param_no;
+			c = ii->int_param1;
+			stop = d == c;
+			k = i + 1;
+			while (stop == 0 && k <= e) {
+				next = &_il[k];
+				if (_o_info[k].flags & OF_TARGET)
+					stop = 1;
+				else {
+					if (next->op == op_read_addr || next->op == op_move) {
+						if (next->int_param1 == d)
+							next->int_param1 = c;
+					} else if (next->op == op_write_addr) {
+						if (next->param_no == d)
+							next->param_no = c;
+						if (next->int_param1 == d)
+							next->int_param1 = c;
+					} else if (next->op == op_jz || next->op == op_jnz || next->op == op_push) {
+						if (next->param_no == d)
+							next->param_no = c;
+					} else if (o_is_binary(next->op)) {
+						if (next->int_param1 == d)
+							next->int_param1 = c;
+					}
+					o_update(k);
+					if (_o_info[k].defs & ((1 << d) | (1 << c)))
+						stop = 1;
+					if (o_is_jump(next->op) || next->op == op_return)
+						stop = 1;
+					k++;
+				}
+			}
+		}
+	}
+}
+
+/* removes computations whose result is never used */
+void o_eliminate(int s, int e)
+{
+	int i, live, changed = 1;
+
+	while (changed) {
+		changed = 0;
+		o_liveness(s, e);
+
+		/* walk blocks backwards so whole chains go in one pass */
+		live = 0;
+		for (i = e; i >= s; i--) {
+			if (o_ends_block(i, e))
+				live = _o_info[i].live;
+			if ((_o_info[i].flags & OF_DEAD) == 0) {
+				if (o_is_pure(_il[i].op) && (live & (1 << _il[i].param_no)) == 0 && (_o_info[i].flags & OF_KEEP) == 0) {
+					_o_info[i].flags |= OF_DEAD;
+					o_update(i);
+					changed = 1;
+				} else
+					live = _o_info[i].uses | (live - (live & _o_info[i].defs));
+			}
+		}
+	}
+}
+
+/* is instruction k the only user of global address in register d */
+int o_folds_into(int k, int d)
+{
+	il_instr *ii = &_il[k];
+	int dead = (_o_info[k].live & (1 << d)) == 0;
+
+	if (ii->int_param1 != d)
+		return 0;
+	if (ii->op == op_read_addr)
+		if (dead || ii->param_no == d)
+			return 1;
+	if (ii->op == op_write_addr)
+		if (dead && ii->param_no != d)
+			return 1;
+	return 0;
+}
+
+/* moves global addresses next to their only access, so backends can merge them */
+void o_fold_addresses(int s, int e)
+{
+	il_instr *ii;
+	il_instr *moved;
+	value_def *val;
+	int i, k, d, skipped, found;
+
+	for (i = s; i <= e; i++) {
+		ii = &_il[i];
+		if (ii->op == op_get_var_addr && (_o_info[i].flags & (OF_DEAD | OF_KEEP)) == 0 && _o_info[i].vn >= 0) {
+			val = &_o_values[_o_info[i].vn];
+			if (val->base != NULL)
+				if (val->base->global) {
+					/* find the next instruction touching the register */
+					d = ii->param_no;
+					k = i;
+					skipped = 0;
+					found = 0;
+					while (found == 0) {
+						k++;
+						if (k > e || (_o_info[k].flags & OF_TARGET) != 0)
+							found = -1;
+						else if (((_o_info[k].uses | _o_info[k].defs) & (1 << d)) != 0) {
+							found = -1;
+							if (o_folds_into(k, d))
+								found = 1;
+						} else if (_o_info[k].target >= 0 || (_o_info[k].flags & OF_STOP) != 0)
+							found = -1;
+						else if ((_o_info[k].flags & OF_DEAD) == 0)
+							skipped = 1;
+					}
+					if (found == 1) {
+						if (skipped) {
+							moved = o_hoist(op_get_var_addr, d, k);
+							moved->string_param1 = ii->string_param1;
+							moved->int_param2 = 1;
+							_o_info[i].flags |= OF_DEAD;
+							o_update(i);
+						} else
+							ii->int_param2 = 1;
+					}
+				}
+		}
+	}
+}
+
+/* does function return right after instruction i without doing anything else */
+int o_returns_after(int i, int e)
+{
+	il_op op;
+	int n;
+
+	i++;
+	for (n = 0; n < 16 && i <= e; n++) {
+		op = _il[i].op;
+		if (op == op_return || op == op_exit_point)
+			return 1;
+		if (op == op_jump)
+			i = _il[i].int_param1;
+		else if (op == op_block_end || op == op_label || (_o_info[i].flags & OF_DEAD) != 0)
+			i++;
+		else
+			return 0;
+	}
+	return 0;
+}
+
+/* turns calls in tail position into jumps reusing the caller's frame */
+void o_tail_calls(int s, int e)
+{
+	function_def *fn;
+	int i;
+
+	/* callee's frame replaces locals, which must not be reachable */
+	if (_o_param_escape)
+		return;
+	for (i = 0; i < _o_usage_idx; i++)
+		if (_o_usage[i].global == 0 && _o_usage[i].escapes != 0)
+			return;
+
+	/* calls into another unit stay calls, a jump to them cannot be relocated, nor one whose arguments the restored parameter registers would overwrite */
+	for (i = s; i <= e; i++)
+		if (_il[i].op == op_function_call && _il[i].param_no == 0 && (_o_info[i].flags & OF_DEAD) == 0) {
+			fn = find_function(_il[i].string_param1);
+			if (o_returns_after(i, e) && (fn->entry_point >= 0) && (fn->num_params <= _backend->first_saved_param)) {
+				_il[i].op = op_tail_call;
+				_il[i].int_param2 = _o_fn->cache_regs; /* registers to restore */
+				if (_il[i + 1].op == op_return && (_o_info[i + 1].flags & OF_TARGET) == 0)
+					_o_info[i + 1].flags |= OF_DEAD;
+			}
+		}
+}
+
+/* orders hoisted instructions from h on by insert position, keeping their sequence */
+void o_sort_hoisted(int h)
+{
+	il_instr tmp;
+	int i, j, pos;
+
+	for (i = h + 1; i < _o_hoisted_idx; i++) {
+		j = i;
+		while (j > h && _o_hoisted_pos[j - 1] > _o_hoisted_pos[j]) {
+			memcpy(&tmp, &_o_hoisted[j], sizeof(il_instr));
+			memcpy(&_o_hoisted[j], &_o_hoisted[j - 1], sizeof(il_instr));
+			memcpy(&_o_hoisted[j - 1], &tmp, sizeof(il_instr));
+			pos = _o_hoisted_pos[j];
+			_o_hoisted_pos[j] = _o_hoisted_pos[j - 1];
+			_o_hoisted_pos[j - 1] = pos;
+			j--;
+		}
+	}
+}
+
+/* is there a hoisted instruction h to insert before IL index i */
+int o_hoisted_at(int h, int i)
+{
+	if (h < _o_hoisted_idx)
+		if (_o_hoisted_pos[h] == i)
+			return 1;
+	return 0;
+}
+
+/* rebuilds IL with hoisted instructions inserted and dead ones removed */
+void o_rebuild()
+{
+	il_instr *ii;
+	int i, j = 0, h = 0;
+
+	for (i = 0; i < _il_idx; i++) {
+		while (o_hoisted_at(h, i)) {
+			if (j >= MAX_IL)
+				error("IL limit exceeded");
+			memcpy(&_o_il[j++], &_o_hoisted[h++], sizeof(il_instr));
+		}
+		_o_info[i].map = j;
+		if ((_o_info[i].flags & OF_DEAD) == 0) {
+			if (j >= MAX_IL)
+				error("IL limit exceeded");
+			memcpy(&_o_il[j++], &_il[i], sizeof(il_instr));
+		}
+	}
+
+	/* update IL references */
+	for (i = 0; i < j; i++) {
+		ii = &_o_il[i];
+		ii->il_index = i;
+		if (o_is_jump(ii->op))
+			ii->int_param1 = _o_info[ii->int_param1].map;
+	}
+	for (i = 0; i < _functions_idx; i++)
+		if (_functions[i].entry_point >= 0) {
+			_functions[i].entry_point = _o_info[_functions[i].entry_point].map;
+			_functions[i].exit_point = _o_info[_functions[i].exit_point].map;
+		}
+
+	ii = _il;
+	_il = _o_il;
+	_o_il = ii;
+	_il_idx = j;
+}
+
+/* can instruction i move within its basic block */
+int o_schedulable(int i)
+{
+	il_op op = _il[i].op;
+
+	if ((_o_info[i].flags & OF_TARGET) != 0)
+		return 0;
+	if (op == op_write_addr)
+		return 1;
+	return o_is_pure(op);
+}
+
+/* makes scheduling node n from instruction i, a folded global address stays glued to its access, returns instructions taken */
+int o_sched_node(int n, int i, int e)
+{
+	sched_def *nd = &_o_sched[n];
+	int last = i;
+
+	nd->first = i;
+	nd->uses = _o_info[i].uses;
+	nd->defs = _o_info[i].defs;
+	if (_il[i].op == op_get_var_addr && _il[i].int_param2 != 0 && i < e && o_schedulable(i + 1)) {
+		last = i + 1;
+		nd->uses |= _o_info[last].uses - (_o_info[last].uses & nd->defs);
+		nd->defs |= _o_info[last].defs;
+	}
+	nd->count = last - i + 1;
+	nd->mem = 0;
+	if (_il[last].op == op_read_addr)
+		nd->mem = 1;
+	if (_il[last].op == op_write_addr)
+		nd->mem = 2;
+	nd->latency = _backend->c_get_latency(&_il[last]);
+	nd->results = 0;
+	nd->after = 0;
+	nd->preds = 0;
+	nd->ready = 0;
+	nd->placed = 0;
+	return nd->count;
+}
+
+/* records dependencies between nodes of a region and how long each path through them is */
+void o_sched_dependencies(int n)
+{
+	sched_def *a;
+	sched_def *b;
+	int j, k, h;
+
+	for (j = 0; j < n; j++) {
+		a = &_o_sched[j];
+		for (k = j + 1; k < n; k++) {
+			b = &_o_sched[k];
+			if ((b->uses & a->defs) != 0)
+				a->results |= 1 << k;
+			else if ((b->defs & (a->uses | a->defs)) != 0)
+				a->after |= 1 << k;
+			else if ((a->mem | b->mem) > 1 && a->mem != 0 && b->mem != 0)
+				/* writes stay ordered with every other access */
+				a->after |= 1 << k;
+			if (((a->results | a->after) & (1 << k)) != 0)
+				b->preds++;
+		}
+	}
+
+	for (j = n - 1; j >= 0; j--) {
+		a = &_o_sched[j];
+		a->height = a->latency;
+		for (k = j + 1; k < n; k++) {
+			h = 0;
+			if ((a->results & (1 << k)) != 0)
+				h = a->latency + _o_sched[k].height;
+			else if ((a->after & (1 << k)) != 0)
+				h = 1 + _o_sched[k].height;
+			if (h > a->height)
+				a->height = h;
+		}
+	}
+}
+
+/* list scheduling of nodes n taken from IL at s, picks the node that can start first, preferring the longest path */
+void o_sched_region(int s, int n)
+{
+	sched_def *nd;
+	int i, j, k, best, start, best_start = 0, cycle = 0, pos = s;
+
+	o_sched_dependencies(n);
+	for (i = 0; i < n; i++) {
+		best = -1;
+		for (k = 0; k < n; k++) {
+			nd = &_o_sched[k];
+			if (nd->placed == 0 && nd->preds == 0) {
+				start = nd->ready;
+				if (start < cycle)
+					start = cycle;
+				if (best < 0 || start < best_start || (start == best_start && nd->height > _o_sched[best].height)) {
+					best = k;
+					best_start = start;
+				}
+			}
+		}
+
+		nd = &_o_sched[best];
+		nd->placed = 1;
+		for (j = 0; j < nd->count; j++)
+			memcpy(&_o_il[pos++], &_il[nd->first + j], sizeof(il_instr));
+		cycle = best_start + nd->count;
+
+		for (k = 0; k < n; k++) {
+			start = -1;
+			if ((nd->results & (1 << k)) != 0)
+				start = best_start + nd->latency;
+			else if ((nd->after & (1 << k)) != 0)
+				start = cycle;
+			if (start >= 0) {
+				_o_sched[k].preds--;
+				if (_o_sched[k].ready < start)
+					_o_sched[k].ready = start;
+			}
+		}
+	}
+
+	for (i = s; i < pos; i++) {
+		memcpy(&_il[i], &_o_il[i], sizeof(il_instr));
+		_il[i].il_index = i;
+	}
+}
+
+/* reorders instructions within basic blocks of function in [s, e] so results are not used right after slow loads and multiplies */
+void o_schedule_function(int s, int e)
+{
+	int i, n = 0, rs = s;
+
+	for (i = s; i <= e; i++) {
+		if (_il[i].op == op_generic)
+			return;
+		_o_info[i].flags = 0;
+	}
+	o_mark_blocks(s, e);
+
+	/* regions are runs of movable instructions, split when too long */
+	i = s;
+	while (i <= e) {
+		if (n == MAX_SCHEDULE) {
+			o_sched_region(rs, n);
+			n = 0;
+		}
+		if (o_schedulable(i)) {
+			if (n == 0)
+				rs = i;
+			i += o_sched_node(n++, i, e);
+		} else {
+			if (n > 1)
+				o_sched_region(rs, n);
+			n = 0;
+			i++;
+		}
+	}
+	if (n > 1)
+		o_sched_region(rs, n);
+}
+
+/* schedules IL of every function */
+void o_schedule()
+{
+	int i;
+
+	if (_backend->c_get_latency == NULL)
+		return;
+	for (i = 0; i < _il_idx; i++)
+		if (_il[i].op == op_entry_point) {
+			_o_fn = find_function(_il[i].string_param1);
+			o_schedule_function(i, _o_fn->exit_point);
+			i = _o_fn->exit_point;
+		}
+}
+
+/* optimizes IL of function in [s, e] */
+void o_optimize_function(int s, int e)
+{
+	il_instr *ii;
+	int i, h = _o_hoisted_idx;
+
+	/* leave functions with inline code or unusual registers alone */
+	for (i = s; i <= e; i++) {
+		ii = &_il[i];
+		if (ii->op == op_generic)
+			return;
+		if (((o_use(ii) | o_def(ii)) >> MAX_PARAMS) != 0)
+			return;
+	}
+
+	o_mark_blocks(s, e);
+	for (i = s; i <= e; i++)
+		_o_info[i].vn = -1;
+	_o_usage_idx = 0;
+	_o_mem = 0;
+	o_reset_values();
+	o_liveness(s, e);
+	o_find_escapes(s, e);
+
+	/* move invariant computations out of loops */
+	o_hoist_function(s, e);
+
+	/* reuse values computed earlier */
+	o_cse_function(s, e);
+
+	/* clean up what became redundant */
+	o_propagate(s, e);
+	o_eliminate(s, e);
+
+	/* global addresses used by a single read or write */
+	o_fold_addresses(s, e);
+
+	/* return through calls at the end */
+	o_tail_calls(s, e);
+	o_sort_hoisted(h);
+}
+
+/* optimizes IL of every function */
+void o_optimize()
+{
+	int i;
+
+	for (i = 0; i < _il_idx; i++)
+		_o_info[i].flags = 0;
+	_o_hoisted_idx = 0;
+
+	for (i = 0; i < _il_idx; i++)
+		if (_il[i].op == op_entry_point) {
+			_o_fn = find_function(_il[i].string_param1);
+			o_optimize_function(i, _o_fn->exit_point);
+			i = _o_fn->exit_point;
+		}
+	o_rebuild();
+
+	/* order instructions for the target pipeline */
+	o_schedule();
+}
@@ -1,17 +1,43 @@
 /* rvcc C compiler - source->IL parser */
 
 void p_read_function_call(function_def *fn, int param_no, block_def *parent);
+void p_read_syscall(int param_no, block_def *parent);
 void p_read_lvalue(lvalue_def *lvalue, variable_def *var, block_def *parent, int param_no, int evaluate,
 		   il_op prefix_op);
 void p_read_expression(int param_no, block_def *parent);
 void p_read_code_block(function_def *function, block_def *parent);
 int p_read_parameter_list_declaration(variable_def vds[], int anon);
-void p_read_function_parameters(block_def *parent);
+int p_read_function_parameters(block_def *parent);
 
+/* offset of a literal among read-only data, written once and shared by identical literals and its suffixes */
 int p_write_symbol(char *data, int len)
 {
-	int startLen = _e_data_idx;
-	e_write_data_string(data, len);
+	int h = 0, i, li, startLen;
+	literal_def *lit;
+
+	/* hashed from the end, so writing it below hashes each suffix on the way */
+	for (i = len - 1; i >= 0; i--)
+		h = (h * 31) + data[i];
+	li = _p_literal_hash[h & (MAX_LITERAL_HASH - 1)];
+	while (li >= 0) {
+		lit = &_p_literals[li];
+		if (strcmp(_e_rodata + lit->offset, data) == 0)
+			return lit->offset;
+		li = lit->next;
+	}
+
+	startLen = _e_rodata_idx;
+	e_write_rodata_string(data, len);
+	h = 0;
+	for (i = len - 1; i >= 0; i--) {
+		h = (h * 31) + data[i];
+		if (_p_literals_idx < MAX_LITERALS) {
+			lit = &_p_literals[_p_literals_idx];
+			lit->offset = startLen + i;
+			lit->next = _p_literal_hash[h & (MAX_LITERAL_HASH - 1)];
+			_p_literal_hash[h & (MAX_LITERAL_HASH - 1)] = _p_literals_idx++;
+		}
+	}
 	return startLen;
 }
 
@@ -32,42 +58,45 @@ void p_initialize()
 	type = add_named_type("void");
 	type->base_type = bt_void;
 	type->size = 0;
+	type->align = 1;
 
 	type = add_named_type("char");
 	type->base_type = bt_char;
 	type->size = 1;
+	type->align = 1;
 
 	type = add_named_type("int");
 	type->base_type = bt_int;
 	type->size = 4;
+	type->align = 4;
 
 	add_block(NULL, NULL); /* global block */
 	e_add_symbol("", 0, 0); /* undef symbol */
 
 	/* architecture defines */
-	add_alias(_backend->source_define, "1");
+	add_alias(_backend->source_define, "1", 0);
 
-	/* binary entry point: read params, call main, exit */
+	/* object files get theirs from the startup object */
+	if (_p_start_code == 0)
+		return;
+
+	/* binary entry point: set up streams, read params, call main, flush streams, exit */
+	fn = add_function("main"); /* declared, its definition may be in another object */
+	fn->num_params = 0;
 	ii = add_instr(op_label);
 	ii->string_param1 = "__start";
-	add_instr(op_start);
+	add_instr(op_start); /* global register for the call below */
+	ii = add_instr(op_function_call);
+	ii->string_param1 = "__stdio_init";
+	add_instr(op_start); /* params again, the call clobbered them */
 	ii = add_instr(op_function_call);
 	ii->string_param1 = "main";
+	ii->int_param1 = 2; /* argc, argv */
+	ii = add_instr(op_function_call);
+	ii->string_param1 = "__stdio_exit"; /* flush open streams */
 	ii = add_instr(op_label);
 	ii->string_param1 = "__exit";
 	add_instr(op_exit);
-
-	/* Linux syscall */
-	fn = add_function("__syscall");
-	fn->num_params = 0;
-	ii = add_instr(op_entry_point);
-	fn->entry_point = ii->il_index;
-	ii->string_param1 = fn->return_def.variable_name;
-	ii = add_instr(op_syscall);
-	ii->string_param1 = fn->return_def.variable_name;
-	ii = add_instr(op_exit_point);
-	ii->string_param1 = fn->return_def.variable_name;
-	fn->exit_point = ii->il_index;
 }
 
 int p_read_numeric_constant(char buffer[])
@@ -111,6 +140,7 @@ void p_read_inner_variable_declaration(variable_def *vd, int anon)
 		p_read_parameter_list_declaration(funargs, 1);
 		vd->is_function = 1;
 	} else {
+		vd->is_function = 0; /* locals are not cleared, their block may reuse freed memory */
 		if (anon == 0) {
 			l_ident(t_identifier, vd->variable_name);
 		}
@@ -124,6 +154,7 @@ void p_read_inner_variable_declaration(variable_def *vd, int anon)
 			} else {
 				/* array without size - just a pointer although could be nested */
 				vd->is_pointer++;
+				vd->array_size = 0;
 			}
 			l_expect(t_cl_square);
 		} else {
@@ -151,7 +182,7 @@ int p_read_parameter_list_declaration(variable_def vds[], int anon)
 {
 	int vn = 0;
 	l_expect(t_op_bracket);
-	while (l_peek(t_identifier, NULL) == 1) {
+	while (l_peek(t_identifier, NULL) || l_peek(t_struct, NULL)) {
 		p_read_full_variable_declaration(&vds[vn++], anon);
 		l_accept(t_comma);
 	}
@@ -377,7 +408,7 @@ void p_read_expression_operand(int param_no, block_def *parent)
 			if (l_peek(t_op_bracket, NULL)) {
 				p_read_pointer_call(param_no, parent);
 			}
-		} else if (fn != NULL) {
+		} else if (fn != NULL || strcmp(token, "__syscall") == 0) {
 			il_instr *ii;
 			int pn;
 
@@ -387,7 +418,10 @@ void p_read_expression_operand(int param_no, block_def *parent)
 			}
 
 			/* we should push existing parameters onto the stack since function calls use same? */
-			p_read_function_call(fn, param_no, parent);
+			if (fn != NULL)
+				p_read_function_call(fn, param_no, parent);
+			else
+				p_read_syscall(param_no, parent);
 
 			for (pn = param_no - 1; pn >= 0; pn--) {
 				ii = add_instr(op_pop);
@@ -570,7 +604,7 @@ void p_read_expression(int param_no, block_def *parent)
 	error("Unexpected end of expression");
 }
 
-void p_read_function_parameters(block_def *parent)
+int p_read_function_parameters(block_def *parent)
 {
 	int param_num = 0;
 	l_expect(t_op_bracket);
@@ -578,6 +612,34 @@ void p_read_function_parameters(block_def *parent)
 		p_read_expression(param_num++, parent);
 		l_accept(t_comma);
 	}
+	return param_num;
+}
+
+/* Linux syscall, compiled inline with arguments placed in the registers the kernel reads */
+void p_read_syscall(int param_no, block_def *parent)
+{
+	il_instr *ii;
+	int args = 0, number = -1, start;
+
+	l_expect(t_identifier);
+	l_expect(t_op_bracket);
+	/* computed number goes first, arguments are moved down after it */
+	start = _il_idx;
+	p_read_expression(args++, parent);
+	if (_il_idx == start + 1 && _il[start].op == op_load_numeric_constant) {
+		/* known number is taken back and loaded next to the trap */
+		number = _il[start].int_param1;
+		_il_idx = start;
+		args = 0;
+	}
+	while (l_accept(t_comma))
+		p_read_expression(args++, parent);
+	l_expect(t_cl_bracket);
+
+	ii = add_instr(op_syscall);
+	ii->param_no = param_no; /* return value here */
+	ii->int_param1 = args; /* registers passed */
+	ii->int_param2 = number;
 }
 
 void p_read_function_call(function_def *fn, int param_no, block_def *parent)
@@ -588,10 +650,11 @@ void p_read_function_call(function_def *fn, int param_no, block_def *parent)
 	l_expect(t_identifier);
 	if (l_peek(t_op_bracket, NULL)) {
 		/* function call */
-		p_read_function_parameters(parent);
+		int args = p_read_function_parameters(parent);
 		ii = add_instr(op_function_call);
 		ii->string_param1 = fn->return_def.variable_name;
 		ii->param_no = param_no; /* return value here */
+		ii->int_param1 = args; /* parameters passed */
 	} else {
 		/* function pointer */
 		ii = add_instr(op_get_var_addr);
@@ -624,10 +687,9 @@ void p_read_lvalue(lvalue_def *lvalue, variable_def *var, block_def *parent, int
 	while (l_peek(t_op_square, NULL) || l_peek(t_arrow, NULL) || l_peek(t_dot, NULL)) {
 		if (l_accept(t_op_square)) {
 			is_reference = 1;
-			if (var->is_pointer <= 1) {
-				/* if nested pointer, still pointer */
+			/* elements of nested pointers and of arrays of pointers are still pointers */
+			if ((var->is_pointer == 0) || ((var->is_pointer == 1) && (var->array_size == 0)))
 				lvalue->size = lvalue->type->size;
-			}
 
 			/* offset, so var must be either a pointer or an array of some type */
 			if (var->is_pointer == 0 && var->array_size == 0)
@@ -635,7 +697,7 @@ void p_read_lvalue(lvalue_def *lvalue, variable_def *var, block_def *parent, int
 
 			/* if var is an array, the memory location points to its start,
 				but if var is a pointer, we need to dereference */
-			if (var->is_pointer) {
+			if ((var->is_pointer > 0) && (var->array_size == 0)) {
 				ii = add_instr(op_read_addr);
 				ii->param_no = param_no;
 				ii->int_param1 = param_no;
@@ -1169,6 +1231,8 @@ void p_read_body_statement(block_def *parent)
 		return;
 	}
 
+	l_accept(t_struct); /* ignore struct before type of a local */
+
 	/* must be an identifier */
 	if (!l_peek(t_identifier, token)) {
 		error("Unexpected token");
@@ -1220,6 +1284,12 @@ void p_read_body_statement(block_def *parent)
 		return;
 	}
 
+	if (strcmp(token, "__syscall") == 0) {
+		p_read_syscall(0, parent);
+		l_expect(t_semicolon);
+		return;
+	}
+
 	/* is it a function call? */
 	fn = find_function(token);
 	if (fn != NULL) {
@@ -1266,11 +1336,170 @@ void p_read_function_body(function_def *fdef)
 	fdef->exit_point = ii->il_index;
 }
 
-/* if first token in is type */
-void p_read_global_declaration(block_def *block)
+/* constant value of a global initializer: number, character or enum, optionally negated */
+int p_read_constant()
+{
+	char token[MAX_ID_LEN];
+	constant_def *cd;
+	int value;
+
+	if (l_accept(t_minus))
+		return -p_read_constant();
+	if (l_peek(t_numeric, token)) {
+		l_expect(t_numeric);
+		return p_read_numeric_constant(token);
+	}
+	if (l_peek(t_char, NULL)) {
+		l_ident(t_char, token);
+		return token[0];
+	}
+	l_ident(t_identifier, token);
+	cd = find_constant(token);
+	if (cd == NULL)
+		error("Global initializer is not constant");
+	value = cd->value;
+	return value;
+}
+
+/* reads initializer of a scalar, array or struct into zeroed buf at pos, not past limit, returns position after it */
+int p_read_initializer(char *buf, int pos, int limit, char *type_name, int is_pointer, int array_size)
+{
+	char literal[MAX_TOKEN_LEN];
+	type_def *type = find_type(type_name);
+	variable_def *fd;
+	int start = pos, size = PTR_SIZE, i;
+
+	if (array_size != 0) {
+		/* array_size below zero takes the number of elements listed */
+		if (is_pointer == 0)
+			size = type->size;
+		if (array_size > 0)
+			limit = start + (size * array_size);
+		if (l_peek(t_string, NULL) && (is_pointer == 0) && (type->base_type == bt_char)) {
+			l_ident(t_string, literal);
+			i = strlen(literal) + 1;
+			/* characters filling the array exactly leave out the terminating zero */
+			if ((array_size > 0) && (i == (array_size + 1)))
+				i = array_size;
+			if ((pos + i) > limit)
+				error("Initializer string too long");
+			memcpy(buf + pos, literal, i);
+			pos += i;
+		} else {
+			l_expect(t_op_curly);
+			while (!l_accept(t_cl_curly)) {
+				if (((pos + size) > limit) && (array_size > 0))
+					error("Too many initializers");
+				if ((pos + size) > limit)
+					error("Initializer too large");
+				pos = p_read_initializer(buf, pos, limit, type_name, is_pointer, 0);
+				l_accept(t_comma);
+			}
+		}
+		if (array_size < 0)
+			return pos;
+		return limit;
+	}
+
+	if (is_pointer > 0) {
+		if (l_peek(t_string, NULL)) {
+			/* literal's offset, moved along by caller and turned into an address once code length is known */
+			l_ident(t_string, literal);
+			i = p_write_symbol(literal, strlen(literal) + 1);
+			if (_e_relocs_idx >= MAX_RELOCS)
+				error("Too many pointer initializers");
+			_e_relocs[_e_relocs_idx++] = pos;
+		} else
+			i = p_read_constant();
+		return e_write_int(buf, pos, i);
+	}
+
+	if (type->base_type == bt_struct) {
+		l_expect(t_op_curly);
+		i = 0;
+		while (!l_accept(t_cl_curly)) {
+			if (i >= type->num_fields)
+				error("Too many initializers");
+			fd = &type->fields[i];
+			i++;
+			p_read_initializer(buf, start + fd->offset, limit, fd->type_name, fd->is_pointer, fd->array_size);
+			l_accept(t_comma);
+		}
+		return start + type->size;
+	}
+
+	if (type->base_type == bt_char) {
+		buf[pos] = p_read_constant();
+		return pos + 1;
+	}
+	return e_write_int(buf, pos, p_read_constant());
+}
+
+/* places global with its constant initializer in the data section */
+void p_read_global_initializer(variable_def *var)
+{
+	char *buf;
+	type_def *type = find_type(var->type_name);
+	int relocs = _e_relocs_idx, len, limit = MAX_INITIALIZER, size = PTR_SIZE, i;
+
+	/* unsized array, declared as pointer, gets size from an initializer list */
+	if ((var->array_size == 0) && (var->is_pointer > 0) && l_peek(t_op_curly, NULL)) {
+		var->is_pointer--;
+		var->array_size = -1;
+	}
+	if (var->array_size >= 0)
+		limit = size_variable(var);
+	buf = calloc(limit, 1);
+	len = p_read_initializer(buf, 0, limit, var->type_name, var->is_pointer, var->array_size);
+	if (var->array_size < 0) {
+		if (var->is_pointer == 0)
+			size = type->size;
+		var->array_size = 0;
+		while ((var->array_size * size) < len)
+			var->array_size++;
+	}
+
+	e_align();
+	if ((_e_data_idx + size_variable(var)) > MAX_DATA)
+		error("Too much initialized data");
+	var->offset = _e_data_idx;
+	var->init = 1;
+	for (i = relocs; i < _e_relocs_idx; i++)
+		_e_relocs[i] = (_e_relocs[i]) + var->offset;
+	e_write_data_string(buf, size_variable(var));
+	free(buf);
+}
+
+/* skips tokens up to and including the closing brace or semicolon at the current nesting level */
+void p_skip_definition(l_token end)
 {
+	int depth = 0;
+
+	while ((depth > 0) || (l_peek(end, NULL) == 0)) {
+		if (l_peek(t_op_curly, NULL))
+			depth++;
+		else if (l_peek(t_cl_curly, NULL))
+			depth--;
+		else if (l_peek(t_eof, NULL))
+			error("Unexpected end of source");
+		_l_next_token = l_next_token();
+	}
+	l_expect(end);
+}
+
+/* if first token in is type, extern declarations are only resolved by the linker */
+void p_read_global_declaration(block_def *block, int is_extern)
+{
+	variable_def *var;
+	int i;
+
+	/* code and data of clib come from another object */
+	if (_source_idx < _p_declare_end)
+		is_extern = 1;
+
 	/* new function, or variables under parent */
 	p_read_full_variable_declaration(_temp_variable, 0);
+	_temp_variable->init = 0;
 
 	if (l_peek(t_op_bracket, NULL)) {
 		function_def *fd;
@@ -1282,7 +1511,11 @@ void p_read_global_declaration(block_def *block)
 
 		fd->num_params = p_read_parameter_list_declaration(fd->param_defs, 0);
 
-		if (l_peek(t_op_curly, NULL)) {
+		if (l_peek(t_op_curly, NULL) && is_extern) {
+			l_expect(t_op_curly);
+			p_skip_definition(t_cl_curly);
+			return;
+		} else if (l_peek(t_op_curly, NULL)) {
 			ii = add_instr(op_entry_point);
 			ii->string_param1 = fd->return_def.variable_name;
 			fd->entry_point = ii->il_index;
@@ -1296,13 +1529,32 @@ void p_read_global_declaration(block_def *block)
 		error("Syntax error in global declaration");
 	}
 
-	/* it's a variable */
-	memcpy(&block->locals[block->next_local++], _temp_variable, sizeof(variable_def));
-
-	if (l_accept(t_assign))
-		/* we don't support global initialisation */
-		error("Global initialization not supported");
-	else if (l_accept(t_comma))
+	/* it's a variable, defining one declared extern before */
+	var = NULL;
+	for (i = 0; i < block->next_local; i++)
+		if ((block->locals[i].init < 0) && (strcmp(block->locals[i].variable_name, _temp_variable->variable_name) == 0))
+			var = &block->locals[i];
+	if (var == NULL) {
+		if (block->next_local >= MAX_GLOBALS)
+			error("Too many global variables");
+		var = &block->locals[block->next_local++];
+	}
+	memcpy(var, _temp_variable, sizeof(variable_def));
+
+	if (is_extern) {
+		var->init = -1;
+		var->offset = 0;
+		if (l_accept(t_assign))
+			p_skip_definition(t_semicolon);
+		else
+			l_expect(t_semicolon);
+		return;
+	}
+	if (l_accept(t_assign)) {
+		p_read_global_initializer(var);
+		l_expect(t_semicolon);
+		return;
+	} else if (l_accept(t_comma))
 		/* TODO: continuation */
 		error("Global continuation not supported");
 	else if (l_accept(t_semicolon))
@@ -1310,6 +1562,32 @@ void p_read_global_declaration(block_def *block)
 	error("Syntax error in global declaration");
 }
 
+/* places fields at naturally aligned offsets, strictest alignment first if reordering to save padding */
+void p_layout_struct(type_def *type)
+{
+	variable_def *v;
+	int a, i, fa, size = 0, align = 1;
+
+	for (a = PTR_SIZE; a > 0; a = a >> 1) {
+		for (i = 0; i < type->num_fields; i++) {
+			v = &type->fields[i];
+			fa = align_variable(v);
+			/* declaration order takes a single pass */
+			if ((fa == a) || (_p_reorder_fields == 0)) {
+				size = align_offset(size, fa);
+				v->offset = size;
+				size += size_variable(v);
+				if (fa > align)
+					align = fa;
+			}
+		}
+		if (_p_reorder_fields == 0)
+			a = 0;
+	}
+	type->size = align_offset(size, align);
+	type->align = align;
+}
+
 void p_read_global_statement()
 {
 	char token[MAX_ID_LEN];
@@ -1325,12 +1603,13 @@ void p_read_global_statement()
 	} else if (l_accept(t_define)) {
 		char alias[MAX_VAR_LEN];
 		char value[MAX_VAR_LEN];
+		int conditional = _l_ifdef; /* lexer is not past a closing #endif yet */
 
 		l_peek(t_identifier, alias);
 		l_expect(t_identifier);
 		l_peek(t_numeric, value);
 		l_expect(t_numeric);
-		add_alias(alias, value);
+		add_alias(alias, value, conditional);
 	} else if (l_accept(t_typedef)) {
 		if (l_accept(t_enum)) {
 			int val = 0;
@@ -1339,6 +1618,7 @@ void p_read_global_statement()
 
 			type->base_type = bt_int;
 			type->size = 4;
+			type->align = 4;
 			l_expect(t_op_curly);
 			do {
 				l_ident(t_identifier, token);
@@ -1355,7 +1635,7 @@ void p_read_global_statement()
 			l_expect(t_semicolon);
 		} else if (l_accept(t_struct)) {
 			char token[MAX_TYPE_LEN];
-			int i = 0, size = 0;
+			int i = 0;
 			type_def *type = add_type();
 
 			if (l_peek(t_identifier, token)) {
@@ -1366,15 +1646,13 @@ void p_read_global_statement()
 			do {
 				variable_def *v = &type->fields[i++];
 				p_read_full_variable_declaration(v, 0);
-				v->offset = size;
-				size += size_variable(v);
 				l_expect(t_semicolon);
 			} while (!l_accept(t_cl_curly));
 
 			l_ident(t_identifier, token); /* type name */
 			strcpy(type->type_name, token);
-			type->size = size;
 			type->num_fields = i;
+			p_layout_struct(type);
 			type->base_type = bt_struct; /* is this used? */
 			l_expect(t_semicolon);
 		} else {
@@ -1388,22 +1666,47 @@ void p_read_global_statement()
 			}
 			type->base_type = base->base_type;
 			type->size = base->size;
+			type->align = base->align;
 			type->num_fields = 0;
 			l_ident(t_identifier, type->type_name);
 			l_expect(t_semicolon);
 		}
+	} else if (l_accept(t_extern)) {
+		p_read_global_declaration(block, 1);
 	} else if (l_peek(t_identifier, NULL)) {
-		p_read_global_declaration(block);
+		p_read_global_declaration(block, 0);
 	} else {
 		error("Syntax error in global statement");
 	}
 }
 
+void p_read_global_statements()
+{
+	int i;
+
+	while (!l_accept(t_eof))
+		p_read_global_statement();
+
+	/* without clib there are no streams to set up or flush around main */
+	if ((_p_start_code != 0) && (find_function("__stdio_exit") == NULL))
+		for (i = 0; _il[i].op != op_exit; i++)
+			if (_il[i].op == op_function_call)
+				if (strncmp(_il[i].string_param1, "__stdio_", 8) == 0) {
+					_il[i].op = op_label;
+					_il[i].string_param1 = "";
+				}
+}
+
 void p_parse()
 {
 	p_initialize();
 	l_initialize();
-	do {
-		p_read_global_statement();
-	} while (!l_accept(t_eof));
+	p_read_global_statements();
+}
+
+/* parses source loaded at pos on top of what a compile server parsed up to there */
+void p_resume(int pos)
+{
+	l_resume(pos);
+	p_read_global_statements();
 }
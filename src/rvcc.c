@@ -3,6 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
 
 #include "defs.c"
 #include "globals.c"
@@ -10,27 +16,87 @@
 #include "lexer.c"
 #include "source.c"
 #include "elf.c"
+#include "cache.c"
 #include "arch/riscv.c"
 #include "arch/arm.c"
+#include "arch/thumb.c"
 #include "parser.c"
+#include "optimizer.c"
 #include "codegen.c"
+#include "server.c"
+#include "targets.c"
 
-/* embedded clib */
+/* embedded clib, as source and precompiled */
 #include "rvclib.inc"
+#include "rvclib_objects.inc"
 
 int main(int argc, char *argv[])
 {
-	int i = 1, clib = 1;
+	int i = 1, clib = 1, opt = 1, reorder = 0, object = 0, link = 0, clib_object = 0, inputs_idx = 0, cache_size = 0, batch = 0, jobs = 1, setup, targets_idx = 1;
 	arch_t arch = a_riscv;
-	char *outfile = NULL, *infile = NULL;
-
-	printf("rvcc C compiler\n");
+	int targets[MAX_TARGETS];
+	char *define;
+	char *outfile = NULL, *infile = NULL, *precompiled = NULL, *cache_dir = NULL, *server = NULL, *connect_to = NULL;
+	char *inputs[64]; /* objects to link */
 
 	while (i < argc) {
 		if (strcmp(argv[i], "-noclib") == 0)
 			clib = 0;
-		else if (strcmp(argv[i], "-march=arm") == 0)
-			arch = a_arm;
+		else if (strcmp(argv[i], "-noopt") == 0)
+			opt = 0;
+		else if (strcmp(argv[i], "-reorder-fields") == 0)
+			reorder = 1;
+		else if (strcmp(argv[i], "-c") == 0)
+			object = 1;
+		else if (strcmp(argv[i], "-link") == 0)
+			link = 1;
+		else if (strcmp(argv[i], "-clib-object") == 0)
+			clib_object = 1;
+		else if (strcmp(argv[i], "-batch") == 0)
+			batch = 1;
+		else if (strncmp(argv[i], "-march=", 7) == 0) {
+			targets_idx = m_parse_targets(argv[i] + 7, targets);
+			if (targets_idx < 0) {
+				printf("Unsupported architecture!\n");
+				return -1;
+			}
+			arch = targets[0];
+		}
+		else if (strcmp(argv[i], "-cache-dir") == 0)
+			if (i + 1 < argc) {
+				cache_dir = argv[i + 1];
+				i++;
+			} else {
+				abort();
+			}
+		else if (strcmp(argv[i], "-cache-size") == 0)
+			if (i + 1 < argc) {
+				cache_size = atoi(argv[i + 1]);
+				i++;
+			} else {
+				abort();
+			}
+		else if (strcmp(argv[i], "-j") == 0)
+			if (i + 1 < argc) {
+				jobs = atoi(argv[i + 1]);
+				i++;
+			} else {
+				abort();
+			}
+		else if (strcmp(argv[i], "-server") == 0)
+			if (i + 1 < argc) {
+				server = argv[i + 1];
+				i++;
+			} else {
+				abort();
+			}
+		else if (strcmp(argv[i], "-connect") == 0)
+			if (i + 1 < argc) {
+				connect_to = argv[i + 1];
+				i++;
+			} else {
+				abort();
+			}
 		else if (strcmp(argv[i], "-o") == 0)
 			if (i < argc + 1) {
 				outfile = argv[i + 1];
@@ -38,54 +104,187 @@ int main(int argc, char *argv[])
 			} else {
 				abort();
 			}
-		else
+		else if (inputs_idx < 64) {
 			infile = argv[i];
+			inputs[inputs_idx++] = argv[i];
+		} else
+			abort();
 		i++;
 	}
 
-	if (infile == NULL) {
+	/* a client leaves compilation to a server */
+	if (connect_to != NULL)
+		return v_request(connect_to, argc, argv);
+
+	printf("rvcc C compiler\n");
+
+	if ((infile == NULL) && (clib_object == 0) && (server == NULL)) {
 		printf("Missing source file!\n");
-		printf("Usage: rvcc [-o outfile] [-noclib] [-march=riscv|arm] <infile.c>\n");
+		printf("Usage: rvcc [-o outfile] [-noclib] [-noopt] [-reorder-fields] [-march=riscv|riscv-c|arm|thumb2] [-c] "
+		       "[-cache-dir dir [-cache-size MB]] [-connect socket] <infile.c>\n");
+		printf("       rvcc [-o outfile] [-noclib] [-noopt] [-reorder-fields] [-march=arch,arch...] [-c] <infile.c>\n");
+		printf("       rvcc [-o outfile] [-noclib] [-noopt] [-march=riscv|riscv-c|arm|thumb2] -link <infile.o|lib.a>...\n");
+		printf("       rvcc [-o outfile] [-march=riscv|riscv-c|arm|thumb2] -clib-object\n");
+		printf("       rvcc [-noclib] [-reorder-fields] [-march=riscv|riscv-c|arm|thumb2] [-c] -server socket\n");
+		printf("       rvcc [-noclib] [-noopt] [-reorder-fields] [-march=riscv|riscv-c|arm|thumb2] [-c] "
+		       "[-cache-dir dir [-cache-size MB]] [-j jobs] -batch <infile.c|@listfile>...\n");
 		return -1;
 	}
+	if (((server != NULL) || batch) && (link || clib_object)) {
+		printf("Server and batch mode only compile source files!\n");
+		return -1;
+	}
+	if (batch && (outfile != NULL)) {
+		printf("Batch mode names each output after its source file!\n");
+		return -1;
+	}
+	if ((targets_idx > 1) && (link || (cache_dir != NULL) || (server != NULL) || batch || _v_warm)) {
+		printf("Several targets do not combine with -link, -cache-dir or server and batch mode!\n");
+		return -1;
+	}
+
+	/* initialize globals, a server child finds them with clib parsed */
+	if (_v_warm == 0)
+		g_initialize();
+	_p_reorder_fields = reorder;
+	if (cache_size > 0)
+		_k_limit = cache_size << 20;
+	if (outfile == NULL) {
+		if (object || clib_object)
+			outfile = "out.o";
+		else
+			outfile = "out.elf";
+	}
+
+	if (m_initialize_backend(arch) < 0)
+		return -1;
 
-	/* initialize globals */
-	g_initialize();
+	/* startup code and clib precompiled by make clib are linked in rather than compiled again */
+	if (clib && (object == 0) && (clib_object == 0)) {
+		if (_v_warm)
+			precompiled = _v_precompiled;
+		else
+			precompiled = e_clib_object(arch);
+	}
+
+	/* a server child can only compile what the state before loading source is the same for */
+	setup = (arch << 8) + (clib << 4) + (reorder << 3) + (link << 2) + (clib_object << 1) + (object || (precompiled != NULL));
+	if (_v_warm && ((setup != _v_setup) || (server != NULL) || batch)) {
+		printf("Server is set up for another target or options!\n");
+		return -1;
+	}
+	if (object || link || clib_object || (precompiled != NULL))
+		_e_relocatable = 1;
+	if (object || (precompiled != NULL))
+		_p_start_code = 0; /* __start comes with clib when linking */
+
+	if (link && (precompiled != NULL)) {
+		/* nothing to compile */
+		e_add_object(precompiled);
+		for (i = 0; i < inputs_idx; i++)
+			e_add_file(inputs[i]);
+		e_link();
+		e_generate(outfile);
+		return 0;
+	}
 
 	/* include clib */
-	if (clib) {
+	if ((clib || clib_object) && (_v_warm == 0)) {
 		s_clib();
 	}
 
+	/* clib only declares what another object defines */
+	if (object || (precompiled != NULL))
+		_p_declare_end = _source_idx;
+
+	/* everything so far is the same for each source, a server or batch does it once and its children continue from here */
+	if ((server != NULL) || batch) {
+		v_warm_up(setup, precompiled);
+		if (batch)
+			return v_batch(argc, argv, inputs, inputs_idx, jobs);
+		return v_serve(server);
+	}
+
 	/* load source code */
-	s_load(infile);
+	if (object || (precompiled != NULL) || ((link == 0) && (clib_object == 0)))
+		s_load(infile);
+	_source[_source_idx] = 0;
 
 	printf("Loaded %d source bytes\n", _source_idx);
 
-	switch (arch) {
-	case a_arm:
-		a_initialize_backend(_backend);
-		break;
-	case a_riscv:
-		r_initialize_backend(_backend);
-		break;
-	default:
-		printf("Unsupported architecture!\n");
-		return -1;
-	}
+	/* same compiler, source, target and options give the same output, linked objects are not part of the key */
+	if ((cache_dir != NULL) && (link == 0))
+		if (k_start(cache_dir, argv[0], (arch << 8) + (clib << 4) + (opt << 3) + (reorder << 2) + (object << 1) + clib_object)) {
+			if (k_fetch(outfile))
+				return 0;
+			k_start_listing();
+		}
 
 	/* parse source into IL */
-	p_parse();
+	if (_v_warm)
+		p_resume(_v_source_end);
+	else
+		p_parse();
 
 	printf("Parsed into %d IL instructions\n", _il_idx);
 
-	/* generate code from IL */
+	/* several targets share the IL, a child optimizes it and generates code for each of them from here */
+	if (targets_idx > 1) {
+		define = _backend->source_define;
+		i = m_fork_targets(targets_idx);
+		if (i < 0)
+			return m_wait_targets(targets_idx);
+		arch = targets[i];
+		outfile = m_output_name(outfile, arch);
+		m_initialize_backend(arch);
+		printf("Generating %s code into %s\n", m_arch_name(arch), outfile);
+
+		/* IL only fits a target with another define if the source did not tell them apart, and clib precompiled for it */
+		if (precompiled != NULL) {
+			precompiled = e_clib_object(arch);
+			if (precompiled == NULL)
+				m_compile_alone(argc, argv, arch, outfile);
+		}
+		if (_l_conditional && (strcmp(define, _backend->source_define) != 0))
+			m_compile_alone(argc, argv, arch, outfile);
+	}
+
+	/* optimize IL */
+	if (opt) {
+		o_optimize();
+		printf("Optimized into %d IL instructions\n", _il_idx);
+	}
+
+	/* generate code from IL, for where it goes after precompiled clib */
+	if (precompiled != NULL)
+		e_place_after(precompiled);
 	c_generate();
+	k_end_listing();
 
 	printf("Compiled into %d code bytes and %d data bytes\n", _e_code_idx, _e_data_idx);
 
+	if (object || clib_object) {
+		/* output relocatable ELF object */
+		e_output_object(outfile, e_generate_object());
+		k_store(outfile);
+		return 0;
+	}
+
+	if (link) {
+		/* startup code and clib go first, then objects and archives in command line order */
+		e_add_object(e_generate_object());
+		for (i = 0; i < inputs_idx; i++)
+			e_add_file(inputs[i]);
+		e_link();
+	} else if (precompiled != NULL) {
+		e_add_object(precompiled);
+		e_add_object(e_generate_object());
+		e_link();
+	}
+
 	/* output code in ELF */
 	e_generate(outfile);
+	k_store(outfile);
 
 	return 0;
 }
@@ -0,0 +1,311 @@
+/* rvcc C compiler - compile server and batch mode, keep clib parsed and fork a child to compile each source on top of it */
+
+int main(int argc, char *argv[]);
+
+/* Unix socket address, family (little-endian) followed by path, its size or -1 if path is too long */
+int v_address(char *addr, char *path)
+{
+	if (strlen(path) >= 108)
+		return -1;
+	addr[0] = AF_UNIX;
+	addr[1] = 0;
+	strcpy(addr + 2, path);
+	return strlen(path) + 3;
+}
+
+int v_write(int fd, char *buf, int n)
+{
+	int w, i = 0;
+
+	while (i < n) {
+		w = write(fd, buf + i, n - i);
+		if (w <= 0)
+			return -1;
+		i += w;
+	}
+	return 0;
+}
+
+/* exit code of a child, or 128 and signal number */
+int v_exit_code(int status)
+{
+	if ((status & 127) != 0)
+		return 128 + (status & 127);
+	return (status >> 8) & 255;
+}
+
+/* parses whatever was loaded, clib, for children to compile their source on top of */
+void v_warm_up(int setup, char *precompiled)
+{
+	_v_setup = setup;
+	_v_precompiled = precompiled;
+	_v_source_end = _source_idx;
+	_source[_source_idx] = 0;
+	p_parse();
+}
+
+/* in a child, compiles as if run with args, its source goes right after clib where parsing resumes */
+void v_compile(int argc, char *args[])
+{
+	args[0] = "rvcc"; /* cache hashes the running executable */
+	_v_warm = 1;
+	_source_idx = _v_source_end;
+	exit(main(argc, args));
+}
+
+/* client side: passes working directory and command line on, shows output and returns exit code of the compilation */
+int v_request(char *path, int argc, char *argv[])
+{
+	char addr[112];
+	void *sa = addr;
+	char *buf = malloc(MAX_REQUEST);
+	int fd, n, i, len;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connect(fd, sa, v_address(addr, path)) < 0) {
+		printf("Unable to connect to server at %s\n", path);
+		return -1;
+	}
+
+	/* working directory and arguments, each null terminated, then an empty string */
+	if (getcwd(buf, MAX_PATH_LEN) == NULL) {
+		printf("Unable to get working directory\n");
+		return -1;
+	}
+	n = strlen(buf) + 1;
+	for (i = 1; i < argc; i++)
+		if (strcmp(argv[i], "-connect") == 0)
+			i++;
+		else {
+			len = strlen(argv[i]) + 1;
+			if (n + len >= MAX_REQUEST) {
+				printf("Command line too long\n");
+				return -1;
+			}
+			strcpy(buf + n, argv[i]);
+			n += len;
+		}
+	buf[n++] = 0;
+	if (v_write(fd, buf, n) < 0) {
+		printf("Unable to send request\n");
+		return -1;
+	}
+
+	/* output follows, its last byte is the exit code */
+	n = 0;
+	len = read(fd, buf, MAX_REQUEST - 1);
+	while (len > 0) {
+		len += n;
+		v_write(1, buf, len - 1);
+		buf[0] = buf[len - 1];
+		n = 1;
+		len = read(fd, buf + 1, MAX_REQUEST - 1);
+	}
+	close(fd);
+	if (n == 0) {
+		printf("Server closed connection\n");
+		return -1;
+	}
+	return buf[0];
+}
+
+/* reads request into buf, its size or -1 if the client went away */
+int v_read_request(int conn, char *buf)
+{
+	int n = 0, len, done = 0;
+
+	while (done == 0) {
+		len = read(conn, buf + n, MAX_REQUEST - n);
+		if (len <= 0)
+			return -1;
+		n += len;
+		if (n >= 2)
+			if ((buf[n - 1] == 0) && (buf[n - 2] == 0))
+				done = 1;
+		if ((done == 0) && (n == MAX_REQUEST))
+			return -1;
+	}
+	return n;
+}
+
+/* child side: compiles request in the client's working directory with output going to it */
+void v_handle(int conn)
+{
+	char *buf = malloc(MAX_REQUEST);
+	char *args[MAX_REQUEST_ARGS];
+	int argc = 1, i;
+
+	if (v_read_request(conn, buf) < 0)
+		exit(1);
+	dup2(conn, 1);
+	if (chdir(buf) < 0) {
+		printf("Unable to change to directory %s\n", buf);
+		exit(1);
+	}
+
+	i = strlen(buf) + 1;
+	while (buf[i] != 0) {
+		if (argc == MAX_REQUEST_ARGS) {
+			printf("Too many arguments\n");
+			exit(1);
+		}
+		args[argc++] = buf + i;
+		i += strlen(buf + i) + 1;
+	}
+
+	v_compile(argc, args);
+}
+
+/* serves requests one at a time, each in a child that starts from the warmed up state */
+int v_serve(char *path)
+{
+	char addr[112];
+	void *sa = addr;
+	char code[1];
+	int fd, conn, pid, status;
+
+	/* a socket left over by an earlier server has to be removed first, unless that server still answers */
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (bind(fd, sa, v_address(addr, path)) < 0) {
+		conn = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (connect(conn, sa, v_address(addr, path)) >= 0)
+			error("Another server is serving on this socket");
+		close(conn);
+		remove(path);
+		if (bind(fd, sa, v_address(addr, path)) < 0)
+			error("Unable to bind server socket");
+	}
+	if (listen(fd, 16) < 0)
+		error("Unable to listen on server socket");
+	printf("Parsed %d source bytes, serving on %s\n", _v_source_end, path);
+
+	for (;;) {
+		fflush(stdout);
+		conn = accept(fd, NULL, NULL);
+		if (conn >= 0) {
+			pid = fork();
+			if (pid == 0) {
+				close(fd);
+				v_handle(conn);
+			}
+			status = 256; /* exit code 1 if there is no child */
+			if (pid > 0)
+				waitpid(pid, &status, 0);
+			code[0] = v_exit_code(status);
+			send(conn, code, 1, MSG_NOSIGNAL);
+			close(conn);
+		}
+	}
+	return 0;
+}
+
+/* output of a batch unit is named after its source, with .o or .elf in place of the extension */
+char *v_output_name(char *infile, int object)
+{
+	char *name = malloc(strlen(infile) + 5);
+	int i, dot = strlen(infile);
+
+	for (i = 0; infile[i] != 0; i++)
+		if (infile[i] == '.')
+			dot = i;
+		else if (infile[i] == '/')
+			dot = strlen(infile);
+	strncpy(name, infile, dot);
+	if (object)
+		strcpy(name + dot, ".o");
+	else
+		strcpy(name + dot, ".elf");
+	return name;
+}
+
+/* waits for a unit to finish */
+void v_batch_wait()
+{
+	int status = 0;
+
+	if (waitpid(-1, &status, 0) < 0)
+		_v_failed++;
+	else if (v_exit_code(status) != 0)
+		_v_failed++;
+	_v_running--;
+}
+
+/* compiles infile in a child with the batch command line's options, once fewer than jobs units are running */
+void v_batch_unit(int argc, char *argv[], char *inputs[], int inputs_idx, char *infile)
+{
+	char *args[MAX_REQUEST_ARGS];
+	int i, j, n = 1, object = 0, option, pid;
+
+	for (i = 1; i < argc; i++) {
+		option = 1;
+		for (j = 0; j < inputs_idx; j++)
+			if (argv[i] == inputs[j])
+				option = 0;
+		if (strcmp(argv[i], "-batch") == 0)
+			option = 0;
+		if (strcmp(argv[i], "-c") == 0)
+			object = 1;
+		if (strcmp(argv[i], "-j") == 0) {
+			option = 0;
+			i++;
+		}
+		if (option) {
+			if (n + 3 >= MAX_REQUEST_ARGS)
+				error("Too many options");
+			args[n++] = argv[i];
+		}
+	}
+	args[n++] = "-o";
+	args[n++] = v_output_name(infile, object);
+	args[n++] = infile;
+
+	if (_v_running == _v_jobs)
+		v_batch_wait();
+	_v_units++;
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0)
+		v_compile(n, args);
+	if (pid < 0)
+		_v_failed++;
+	else
+		_v_running++;
+}
+
+/* compiles each input, or each one an @file lists, to its own output with up to jobs units at a time */
+int v_batch(int argc, char *argv[], char *inputs[], int inputs_idx, int jobs)
+{
+	char *infile, *list;
+	int i, j, start, size;
+
+	_v_jobs = jobs;
+	if (jobs < 1)
+		_v_jobs = 1;
+	for (i = 0; i < inputs_idx; i++) {
+		infile = inputs[i];
+		if (infile[0] == '@') {
+			/* whole list is read up front, children share its file offset */
+			list = e_read_file(infile + 1, &size);
+			list[size] = 0;
+			j = 0;
+			while (j < size) {
+				/* one source file per line, or separated by other whitespace */
+				start = j;
+				while ((j < size) && (is_whitespace(list[j]) == 0))
+					j++;
+				list[j] = 0;
+				if (j > start)
+					v_batch_unit(argc, argv, inputs, inputs_idx, list + start);
+				j++;
+			}
+		} else
+			v_batch_unit(argc, argv, inputs, inputs_idx, infile);
+	}
+	while (_v_running > 0)
+		v_batch_wait();
+
+	printf("Batch compiled %d of %d source files\n", _v_units - _v_failed, _v_units);
+	if (_v_failed > 0)
+		return 1;
+	return 0;
+}
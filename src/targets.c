@@ -0,0 +1,150 @@
+/* rvcc C compiler - multi-target output, source is parsed once and a child generates code from the IL for each target */
+
+int m_initialize_backend(arch_t arch)
+{
+	switch (arch) {
+	case a_arm:
+		a_initialize_backend(_backend);
+		break;
+	case a_thumb2:
+		t_initialize_backend(_backend);
+		break;
+	case a_riscv:
+		r_initialize_backend(_backend);
+		break;
+	case a_riscv_c:
+		r_initialize_compressed_backend(_backend);
+		break;
+	default:
+		printf("Unsupported architecture!\n");
+		return -1;
+	}
+	return 0;
+}
+
+char *m_arch_name(arch_t arch)
+{
+	switch (arch) {
+	case a_riscv:
+		return "riscv";
+	case a_riscv_c:
+		return "riscv-c";
+	case a_arm:
+		return "arm";
+	case a_thumb2:
+		return "thumb2";
+	default:
+		break;
+	}
+	return NULL;
+}
+
+/* reads comma separated architecture names into targets, their number or -1 if one is unknown, repeats are dropped */
+int m_parse_targets(char *list, int targets[])
+{
+	char name[MAX_VAR_LEN];
+	int i = 0, j, n = 0, len, arch, repeat;
+
+	while (list[i] != 0) {
+		len = 0;
+		while ((list[i] != 0) && (list[i] != ',')) {
+			if (len == MAX_VAR_LEN - 1)
+				return -1;
+			name[len++] = list[i++];
+		}
+		name[len] = 0;
+		if (list[i] == ',')
+			i++;
+
+		arch = -1;
+		for (j = a_riscv; j <= a_thumb2; j++)
+			if (strcmp(name, m_arch_name(j)) == 0)
+				arch = j;
+		if (arch < 0)
+			return -1;
+
+		repeat = 0;
+		for (j = 0; j < n; j++)
+			if (targets[j] == arch)
+				repeat = 1;
+		if (repeat == 0)
+			targets[n++] = arch;
+	}
+	if (n == 0)
+		return -1;
+	return n;
+}
+
+/* output of a target is named with the architecture before the extension, out.elf becomes out.arm.elf */
+char *m_output_name(char *outfile, arch_t arch)
+{
+	char *name = malloc(strlen(outfile) + MAX_VAR_LEN);
+	char *suffix = m_arch_name(arch);
+	int i, dot = strlen(outfile);
+
+	for (i = 0; outfile[i] != 0; i++)
+		if (outfile[i] == '.')
+			dot = i;
+		else if (outfile[i] == '/')
+			dot = strlen(outfile);
+	strncpy(name, outfile, dot);
+	name[dot] = '.';
+	strcpy(name + dot + 1, suffix);
+	strcpy(name + dot + 1 + strlen(suffix), outfile + dot);
+	return name;
+}
+
+/* forks a child for each target, returns the target's index in the child and -1 in the parent */
+int m_fork_targets(int n)
+{
+	int i, pid;
+
+	for (i = 0; i < n; i++) {
+		fflush(stdout);
+		pid = fork();
+		if (pid == 0)
+			return i;
+		if (pid < 0)
+			_m_failed++;
+	}
+	return -1;
+}
+
+/* waits for every target's child to finish */
+int m_wait_targets(int n)
+{
+	int status = 0;
+
+	while (waitpid(-1, &status, 0) > 0)
+		if (v_exit_code(status) != 0)
+			_m_failed++;
+
+	printf("Generated code for %d of %d targets\n", n - _m_failed, n);
+	if (_m_failed > 0)
+		return 1;
+	return 0;
+}
+
+/* in a child, compiles for arch alone with the rest of the command line, when the shared IL does not fit it */
+void m_compile_alone(int argc, char *argv[], arch_t arch, char *outfile)
+{
+	char *args[MAX_REQUEST_ARGS];
+	char *march = malloc(MAX_VAR_LEN + 8);
+	int i, n = 1;
+
+	for (i = 1; i < argc; i++)
+		if (strcmp(argv[i], "-o") == 0)
+			i++;
+		else if (strncmp(argv[i], "-march=", 7) != 0) {
+			if (n + 4 >= MAX_REQUEST_ARGS)
+				error("Too many options");
+			args[n++] = argv[i];
+		}
+	strcpy(march, "-march=");
+	strcpy(march + 7, m_arch_name(arch));
+	args[0] = argv[0];
+	args[n++] = march;
+	args[n++] = "-o";
+	args[n++] = outfile;
+	exit(main(n, args));
+}
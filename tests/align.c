@@ -0,0 +1,60 @@
+#include <stdio.h>
+
+typedef struct {
+	char flag;
+	int value;
+	char tail;
+} mixed_def;
+
+typedef struct {
+	char c;
+	mixed_def inner;
+	char *name;
+} outer_def;
+
+char lone = 'a';
+int after;
+mixed_def table[3];
+
+int aligned(void *p, int a)
+{
+	return ((p - NULL) & (a - 1)) == 0;
+}
+
+int fill(char c, int v, mixed_def *m)
+{
+	char pad;
+	int local;
+	pad = c;
+	local = v;
+	m->flag = pad;
+	m->value = local;
+	m->tail = pad + 1;
+	return aligned(&local, 4);
+}
+
+int main()
+{
+	char a;
+	int b;
+	char c;
+	outer_def o;
+	int i;
+
+	printf("%d %d\n", sizeof(mixed_def), sizeof(outer_def));
+	printf("%d %d %d\n", aligned(&b, 4), aligned(&o, 4), aligned(&o.inner.value, 4));
+	printf("%d %d\n", aligned(&after, 4), aligned(&table[1].value, 4));
+	for (i = 0; i < 3; i++)
+		printf("%d", fill('x' + i, i * 100, &table[i]));
+	printf("\n");
+	for (i = 0; i < 3; i++)
+		printf("%c %d %c\n", table[i].flag, table[i].value, table[i].tail);
+	a = 'p';
+	b = 7;
+	c = 'q';
+	o.c = a;
+	o.inner.value = b;
+	o.name = "outer";
+	printf("%c %d %c %s %c\n", o.c, o.inner.value, c, o.name, lone);
+	return 0;
+}
@@ -0,0 +1,27 @@
+int g_mask;
+char g_name[8];
+
+int mix(int v)
+{
+	int a = 65280; /* rotated immediate */
+	int b = -256; /* inverted immediate */
+	int c = 4660; /* 16-bit */
+	int d = 305419896; /* full word */
+	return (v & a) + b + c + d;
+}
+
+int repeat(int v)
+{
+	/* same constant used twice */
+	return (v | 286331153) + (v & 286331153);
+}
+
+int main(int argc, char *argv[])
+{
+	g_mask = -16777216;
+	strcpy(g_name, "pool");
+	printf("%d\n", mix(4095));
+	printf("%d\n", repeat(3));
+	printf("%d %s\n", g_mask, g_name);
+	return 0;
+}
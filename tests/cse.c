@@ -0,0 +1,52 @@
+typedef struct {
+	int offset;
+	int size;
+} slot_t;
+
+slot_t g_slots[4];
+int g_idx;
+
+int slot_size(slot_t *s)
+{
+	return s->size;
+}
+
+void next_slot()
+{
+	g_idx++;
+}
+
+int reuse(slot_t *slots, int i)
+{
+	slots[i].offset = 7;
+	slots[i].size = slots[i].offset * 2;
+	return slot_size(&slots[i]) + slots[i].offset;
+}
+
+int aliased(int *p, int *q)
+{
+	int a = p[0];
+	q[0] = 10; /* may change p[0] */
+	return a + p[0];
+}
+
+int after_call()
+{
+	int a = g_slots[g_idx].size;
+	next_slot(); /* changes g_idx */
+	return a + g_slots[g_idx].size;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, x = 1;
+
+	for (i = 0; i < 4; i++)
+		g_slots[i].size = i * 100;
+	printf("%d\n", reuse(g_slots, 2));
+	printf("%d %d\n", g_slots[2].offset, g_slots[2].size);
+	printf("%d\n", aliased(&x, &x));
+	g_idx = 1;
+	printf("%d\n", after_call());
+	return 0;
+}
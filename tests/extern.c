@@ -0,0 +1,116 @@
+extern int counter;
+extern char *names[3];
+
+int bump(int n);
+int sum_names();
+
+int use_before_definition()
+{
+	bump(3);
+	bump(4);
+	return counter;
+}
+
+int counter;
+char *names[3] = {"one", "two", "three"};
+
+int bump(int n)
+{
+	counter = counter + n;
+	return counter;
+}
+
+int sum_names()
+{
+	int i, s = 0;
+	for (i = 0; i < 3; i++)
+		s = s + strlen(names[i]);
+	return s;
+}
+
+/* arguments after the fourth go in r4-r7 on ARM */
+int eight(int a, int b, int c, int d, int e, int f, int g, int h)
+{
+	return a + b + c + d + e + f + g + h;
+}
+
+int touch(int x)
+{
+	return eight(x, x, x, x, x, x, x, x);
+}
+
+/* foreign callers keep values in callee-saved registers across a call, these are hand-written ones holding 100-103 */
+#ifdef __ARM
+int hold_arm(int x)
+{
+	_asm(0xe92d00f0); /* push {r4-r7} */
+	_asm(0xe3a04064); /* mov r4, #100 */
+	_asm(0xe3a05065); /* mov r5, #101 */
+	_asm(0xe3a06066); /* mov r6, #102 */
+	_asm(0xe3a07067); /* mov r7, #103 */
+	touch(x);
+	_asm(0xe0840005); /* add r0, r4, r5 */
+	_asm(0xe0800006); /* add r0, r0, r6 */
+	_asm(0xe0800007); /* add r0, r0, r7 */
+	_asm(0xe8bd00f0); /* pop {r4-r7} */
+}
+
+int hold_thumb(int x)
+{
+	_asm(0x00f0e92d); /* push.w {r4-r7} */
+	_asm(0x0464f240); /* movw r4, #100 */
+	_asm(0x0565f240); /* movw r5, #101 */
+	_asm(0x0666f240); /* movw r6, #102 */
+	_asm(0x0767f240); /* movw r7, #103 */
+	touch(x);
+	_asm(0x44284620); /* mov r0, r4; add r0, r5 */
+	_asm(0x44384430); /* add r0, r6; add r0, r7 */
+	_asm(0x00f0e8bd); /* pop.w {r4-r7} */
+}
+
+/* Thumb code addresses have their low bit set */
+int hold(int x)
+{
+	int thumb = hold_thumb;
+
+	if (thumb & 1)
+		return hold_thumb(x);
+	return hold_arm(x);
+}
+#endif
+
+#ifdef __RISCV
+int hold(int x)
+{
+	_asm(0xff010113); /* addi sp, sp, -16 */
+	_asm(0x01212023); /* sw s2, 0(sp) */
+	_asm(0x01312223); /* sw s3, 4(sp) */
+	_asm(0x01412423); /* sw s4, 8(sp) */
+	_asm(0x01512623); /* sw s5, 12(sp) */
+	_asm(0x06400913); /* li s2, 100 */
+	_asm(0x06500993); /* li s3, 101 */
+	_asm(0x06600a13); /* li s4, 102 */
+	_asm(0x06700a93); /* li s5, 103 */
+	touch(x);
+	_asm(0x01390533); /* add a0, s2, s3 */
+	_asm(0x01450533); /* add a0, a0, s4 */
+	_asm(0x01550533); /* add a0, a0, s5 */
+	_asm(0x00012903); /* lw s2, 0(sp) */
+	_asm(0x00412983); /* lw s3, 4(sp) */
+	_asm(0x00812a03); /* lw s4, 8(sp) */
+	_asm(0x00c12a83); /* lw s5, 12(sp) */
+	_asm(0x01010113); /* addi sp, sp, 16 */
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	int (*f)(int);
+
+	printf("%d\n", use_before_definition());
+	f = bump;
+	printf("%d\n", f(10));
+	printf("%d %s\n", sum_names(), names[2]);
+	printf("%d\n", hold(5));
+	return 0;
+}
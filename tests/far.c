@@ -0,0 +1,823 @@
+/* the bodies below are too long for short conditional branches */
+int far_sum(int n)
+{
+	int i, s = 0;
+	for (i = 0; i < n; i++) {
+		if (i == 1)
+			s = s + 3;
+		if (i == 2)
+			s = s + 6;
+		if (i == 3)
+			s = s + 9;
+		if (i == 4)
+			s = s + 12;
+		if (i == 5)
+			s = s + 15;
+		if (i == 6)
+			s = s + 18;
+		if (i == 7)
+			s = s + 21;
+		if (i == 8)
+			s = s + 24;
+		if (i == 9)
+			s = s + 27;
+		if (i == 10)
+			s = s + 30;
+		if (i == 11)
+			s = s + 33;
+		if (i == 12)
+			s = s + 36;
+		if (i == 13)
+			s = s + 39;
+		if (i == 14)
+			s = s + 42;
+		if (i == 15)
+			s = s + 45;
+		if (i == 16)
+			s = s + 48;
+		if (i == 17)
+			s = s + 51;
+		if (i == 18)
+			s = s + 54;
+		if (i == 19)
+			s = s + 57;
+		if (i == 20)
+			s = s + 60;
+		if (i == 21)
+			s = s + 63;
+		if (i == 22)
+			s = s + 66;
+		if (i == 23)
+			s = s + 69;
+		if (i == 24)
+			s = s + 72;
+		if (i == 25)
+			s = s + 75;
+		if (i == 26)
+			s = s + 78;
+		if (i == 27)
+			s = s + 81;
+		if (i == 28)
+			s = s + 84;
+		if (i == 29)
+			s = s + 87;
+		if (i == 30)
+			s = s + 90;
+		if (i == 31)
+			s = s + 93;
+		if (i == 32)
+			s = s + 96;
+		if (i == 33)
+			s = s + 99;
+		if (i == 34)
+			s = s + 102;
+		if (i == 35)
+			s = s + 105;
+		if (i == 36)
+			s = s + 108;
+		if (i == 37)
+			s = s + 111;
+		if (i == 38)
+			s = s + 114;
+		if (i == 39)
+			s = s + 117;
+		if (i == 40)
+			s = s + 120;
+		if (i == 41)
+			s = s + 123;
+		if (i == 42)
+			s = s + 126;
+		if (i == 43)
+			s = s + 129;
+		if (i == 44)
+			s = s + 132;
+		if (i == 45)
+			s = s + 135;
+		if (i == 46)
+			s = s + 138;
+		if (i == 47)
+			s = s + 141;
+		if (i == 48)
+			s = s + 144;
+		if (i == 49)
+			s = s + 147;
+		if (i == 50)
+			s = s + 150;
+		if (i == 51)
+			s = s + 153;
+		if (i == 52)
+			s = s + 156;
+		if (i == 53)
+			s = s + 159;
+		if (i == 54)
+			s = s + 162;
+		if (i == 55)
+			s = s + 165;
+		if (i == 56)
+			s = s + 168;
+		if (i == 57)
+			s = s + 171;
+		if (i == 58)
+			s = s + 174;
+		if (i == 59)
+			s = s + 177;
+		if (i == 60)
+			s = s + 180;
+		if (i == 61)
+			s = s + 183;
+		if (i == 62)
+			s = s + 186;
+		if (i == 63)
+			s = s + 189;
+		if (i == 64)
+			s = s + 192;
+		if (i == 65)
+			s = s + 195;
+		if (i == 66)
+			s = s + 198;
+		if (i == 67)
+			s = s + 201;
+		if (i == 68)
+			s = s + 204;
+		if (i == 69)
+			s = s + 207;
+		if (i == 70)
+			s = s + 210;
+		if (i == 71)
+			s = s + 213;
+		if (i == 72)
+			s = s + 216;
+		if (i == 73)
+			s = s + 219;
+		if (i == 74)
+			s = s + 222;
+		if (i == 75)
+			s = s + 225;
+		if (i == 76)
+			s = s + 228;
+		if (i == 77)
+			s = s + 231;
+		if (i == 78)
+			s = s + 234;
+		if (i == 79)
+			s = s + 237;
+		if (i == 80)
+			s = s + 240;
+		if (i == 81)
+			s = s + 243;
+		if (i == 82)
+			s = s + 246;
+		if (i == 83)
+			s = s + 249;
+		if (i == 84)
+			s = s + 252;
+		if (i == 85)
+			s = s + 255;
+		if (i == 86)
+			s = s + 258;
+		if (i == 87)
+			s = s + 261;
+		if (i == 88)
+			s = s + 264;
+		if (i == 89)
+			s = s + 267;
+		if (i == 90)
+			s = s + 270;
+		if (i == 91)
+			s = s + 273;
+		if (i == 92)
+			s = s + 276;
+		if (i == 93)
+			s = s + 279;
+		if (i == 94)
+			s = s + 282;
+		if (i == 95)
+			s = s + 285;
+		if (i == 96)
+			s = s + 288;
+		if (i == 97)
+			s = s + 291;
+		if (i == 98)
+			s = s + 294;
+		if (i == 99)
+			s = s + 297;
+		if (i == 100)
+			s = s + 300;
+		if (i == 101)
+			s = s + 303;
+		if (i == 102)
+			s = s + 306;
+		if (i == 103)
+			s = s + 309;
+		if (i == 104)
+			s = s + 312;
+		if (i == 105)
+			s = s + 315;
+		if (i == 106)
+			s = s + 318;
+		if (i == 107)
+			s = s + 321;
+		if (i == 108)
+			s = s + 324;
+		if (i == 109)
+			s = s + 327;
+		if (i == 110)
+			s = s + 330;
+		if (i == 111)
+			s = s + 333;
+		if (i == 112)
+			s = s + 336;
+		if (i == 113)
+			s = s + 339;
+		if (i == 114)
+			s = s + 342;
+		if (i == 115)
+			s = s + 345;
+		if (i == 116)
+			s = s + 348;
+		if (i == 117)
+			s = s + 351;
+		if (i == 118)
+			s = s + 354;
+		if (i == 119)
+			s = s + 357;
+		if (i == 120)
+			s = s + 360;
+		if (i == 121)
+			s = s + 363;
+		if (i == 122)
+			s = s + 366;
+		if (i == 123)
+			s = s + 369;
+		if (i == 124)
+			s = s + 372;
+		if (i == 125)
+			s = s + 375;
+		if (i == 126)
+			s = s + 378;
+		if (i == 127)
+			s = s + 381;
+		if (i == 128)
+			s = s + 384;
+		if (i == 129)
+			s = s + 387;
+		if (i == 130)
+			s = s + 390;
+		if (i == 131)
+			s = s + 393;
+		if (i == 132)
+			s = s + 396;
+		if (i == 133)
+			s = s + 399;
+		if (i == 134)
+			s = s + 402;
+		if (i == 135)
+			s = s + 405;
+		if (i == 136)
+			s = s + 408;
+		if (i == 137)
+			s = s + 411;
+		if (i == 138)
+			s = s + 414;
+		if (i == 139)
+			s = s + 417;
+		if (i == 140)
+			s = s + 420;
+		if (i == 141)
+			s = s + 423;
+		if (i == 142)
+			s = s + 426;
+		if (i == 143)
+			s = s + 429;
+		if (i == 144)
+			s = s + 432;
+		if (i == 145)
+			s = s + 435;
+		if (i == 146)
+			s = s + 438;
+		if (i == 147)
+			s = s + 441;
+		if (i == 148)
+			s = s + 444;
+		if (i == 149)
+			s = s + 447;
+		if (i == 150)
+			s = s + 450;
+		if (i == 151)
+			s = s + 453;
+		if (i == 152)
+			s = s + 456;
+		if (i == 153)
+			s = s + 459;
+		if (i == 154)
+			s = s + 462;
+		if (i == 155)
+			s = s + 465;
+		if (i == 156)
+			s = s + 468;
+		if (i == 157)
+			s = s + 471;
+		if (i == 158)
+			s = s + 474;
+		if (i == 159)
+			s = s + 477;
+		if (i == 160)
+			s = s + 480;
+		if (i == 161)
+			s = s + 483;
+		if (i == 162)
+			s = s + 486;
+		if (i == 163)
+			s = s + 489;
+		if (i == 164)
+			s = s + 492;
+		if (i == 165)
+			s = s + 495;
+		if (i == 166)
+			s = s + 498;
+		if (i == 167)
+			s = s + 501;
+		if (i == 168)
+			s = s + 504;
+		if (i == 169)
+			s = s + 507;
+		if (i == 170)
+			s = s + 510;
+		if (i == 171)
+			s = s + 513;
+		if (i == 172)
+			s = s + 516;
+		if (i == 173)
+			s = s + 519;
+		if (i == 174)
+			s = s + 522;
+		if (i == 175)
+			s = s + 525;
+		if (i == 176)
+			s = s + 528;
+		if (i == 177)
+			s = s + 531;
+		if (i == 178)
+			s = s + 534;
+		if (i == 179)
+			s = s + 537;
+		if (i == 180)
+			s = s + 540;
+		if (i == 181)
+			s = s + 543;
+		if (i == 182)
+			s = s + 546;
+		if (i == 183)
+			s = s + 549;
+		if (i == 184)
+			s = s + 552;
+		if (i == 185)
+			s = s + 555;
+		if (i == 186)
+			s = s + 558;
+		if (i == 187)
+			s = s + 561;
+		if (i == 188)
+			s = s + 564;
+		if (i == 189)
+			s = s + 567;
+		if (i == 190)
+			s = s + 570;
+		if (i == 191)
+			s = s + 573;
+		if (i == 192)
+			s = s + 576;
+		if (i == 193)
+			s = s + 579;
+		if (i == 194)
+			s = s + 582;
+		if (i == 195)
+			s = s + 585;
+		if (i == 196)
+			s = s + 588;
+		if (i == 197)
+			s = s + 591;
+		if (i == 198)
+			s = s + 594;
+		if (i == 199)
+			s = s + 597;
+		if (i == 200)
+			s = s + 600;
+	}
+	return s;
+}
+
+int far_if(int x)
+{
+	int s = 0;
+	if (x > 5) {
+		if (x == 1)
+			s = 7;
+		if (x == 2)
+			s = 14;
+		if (x == 3)
+			s = 21;
+		if (x == 4)
+			s = 28;
+		if (x == 5)
+			s = 35;
+		if (x == 6)
+			s = 42;
+		if (x == 7)
+			s = 49;
+		if (x == 8)
+			s = 56;
+		if (x == 9)
+			s = 63;
+		if (x == 10)
+			s = 70;
+		if (x == 11)
+			s = 77;
+		if (x == 12)
+			s = 84;
+		if (x == 13)
+			s = 91;
+		if (x == 14)
+			s = 98;
+		if (x == 15)
+			s = 105;
+		if (x == 16)
+			s = 112;
+		if (x == 17)
+			s = 119;
+		if (x == 18)
+			s = 126;
+		if (x == 19)
+			s = 133;
+		if (x == 20)
+			s = 140;
+		if (x == 21)
+			s = 147;
+		if (x == 22)
+			s = 154;
+		if (x == 23)
+			s = 161;
+		if (x == 24)
+			s = 168;
+		if (x == 25)
+			s = 175;
+		if (x == 26)
+			s = 182;
+		if (x == 27)
+			s = 189;
+		if (x == 28)
+			s = 196;
+		if (x == 29)
+			s = 203;
+		if (x == 30)
+			s = 210;
+		if (x == 31)
+			s = 217;
+		if (x == 32)
+			s = 224;
+		if (x == 33)
+			s = 231;
+		if (x == 34)
+			s = 238;
+		if (x == 35)
+			s = 245;
+		if (x == 36)
+			s = 252;
+		if (x == 37)
+			s = 259;
+		if (x == 38)
+			s = 266;
+		if (x == 39)
+			s = 273;
+		if (x == 40)
+			s = 280;
+		if (x == 41)
+			s = 287;
+		if (x == 42)
+			s = 294;
+		if (x == 43)
+			s = 301;
+		if (x == 44)
+			s = 308;
+		if (x == 45)
+			s = 315;
+		if (x == 46)
+			s = 322;
+		if (x == 47)
+			s = 329;
+		if (x == 48)
+			s = 336;
+		if (x == 49)
+			s = 343;
+		if (x == 50)
+			s = 350;
+		if (x == 51)
+			s = 357;
+		if (x == 52)
+			s = 364;
+		if (x == 53)
+			s = 371;
+		if (x == 54)
+			s = 378;
+		if (x == 55)
+			s = 385;
+		if (x == 56)
+			s = 392;
+		if (x == 57)
+			s = 399;
+		if (x == 58)
+			s = 406;
+		if (x == 59)
+			s = 413;
+		if (x == 60)
+			s = 420;
+		if (x == 61)
+			s = 427;
+		if (x == 62)
+			s = 434;
+		if (x == 63)
+			s = 441;
+		if (x == 64)
+			s = 448;
+		if (x == 65)
+			s = 455;
+		if (x == 66)
+			s = 462;
+		if (x == 67)
+			s = 469;
+		if (x == 68)
+			s = 476;
+		if (x == 69)
+			s = 483;
+		if (x == 70)
+			s = 490;
+		if (x == 71)
+			s = 497;
+		if (x == 72)
+			s = 504;
+		if (x == 73)
+			s = 511;
+		if (x == 74)
+			s = 518;
+		if (x == 75)
+			s = 525;
+		if (x == 76)
+			s = 532;
+		if (x == 77)
+			s = 539;
+		if (x == 78)
+			s = 546;
+		if (x == 79)
+			s = 553;
+		if (x == 80)
+			s = 560;
+		if (x == 81)
+			s = 567;
+		if (x == 82)
+			s = 574;
+		if (x == 83)
+			s = 581;
+		if (x == 84)
+			s = 588;
+		if (x == 85)
+			s = 595;
+		if (x == 86)
+			s = 602;
+		if (x == 87)
+			s = 609;
+		if (x == 88)
+			s = 616;
+		if (x == 89)
+			s = 623;
+		if (x == 90)
+			s = 630;
+		if (x == 91)
+			s = 637;
+		if (x == 92)
+			s = 644;
+		if (x == 93)
+			s = 651;
+		if (x == 94)
+			s = 658;
+		if (x == 95)
+			s = 665;
+		if (x == 96)
+			s = 672;
+		if (x == 97)
+			s = 679;
+		if (x == 98)
+			s = 686;
+		if (x == 99)
+			s = 693;
+		if (x == 100)
+			s = 700;
+		if (x == 101)
+			s = 707;
+		if (x == 102)
+			s = 714;
+		if (x == 103)
+			s = 721;
+		if (x == 104)
+			s = 728;
+		if (x == 105)
+			s = 735;
+		if (x == 106)
+			s = 742;
+		if (x == 107)
+			s = 749;
+		if (x == 108)
+			s = 756;
+		if (x == 109)
+			s = 763;
+		if (x == 110)
+			s = 770;
+		if (x == 111)
+			s = 777;
+		if (x == 112)
+			s = 784;
+		if (x == 113)
+			s = 791;
+		if (x == 114)
+			s = 798;
+		if (x == 115)
+			s = 805;
+		if (x == 116)
+			s = 812;
+		if (x == 117)
+			s = 819;
+		if (x == 118)
+			s = 826;
+		if (x == 119)
+			s = 833;
+		if (x == 120)
+			s = 840;
+		if (x == 121)
+			s = 847;
+		if (x == 122)
+			s = 854;
+		if (x == 123)
+			s = 861;
+		if (x == 124)
+			s = 868;
+		if (x == 125)
+			s = 875;
+		if (x == 126)
+			s = 882;
+		if (x == 127)
+			s = 889;
+		if (x == 128)
+			s = 896;
+		if (x == 129)
+			s = 903;
+		if (x == 130)
+			s = 910;
+		if (x == 131)
+			s = 917;
+		if (x == 132)
+			s = 924;
+		if (x == 133)
+			s = 931;
+		if (x == 134)
+			s = 938;
+		if (x == 135)
+			s = 945;
+		if (x == 136)
+			s = 952;
+		if (x == 137)
+			s = 959;
+		if (x == 138)
+			s = 966;
+		if (x == 139)
+			s = 973;
+		if (x == 140)
+			s = 980;
+		if (x == 141)
+			s = 987;
+		if (x == 142)
+			s = 994;
+		if (x == 143)
+			s = 1001;
+		if (x == 144)
+			s = 1008;
+		if (x == 145)
+			s = 1015;
+		if (x == 146)
+			s = 1022;
+		if (x == 147)
+			s = 1029;
+		if (x == 148)
+			s = 1036;
+		if (x == 149)
+			s = 1043;
+		if (x == 150)
+			s = 1050;
+		if (x == 151)
+			s = 1057;
+		if (x == 152)
+			s = 1064;
+		if (x == 153)
+			s = 1071;
+		if (x == 154)
+			s = 1078;
+		if (x == 155)
+			s = 1085;
+		if (x == 156)
+			s = 1092;
+		if (x == 157)
+			s = 1099;
+		if (x == 158)
+			s = 1106;
+		if (x == 159)
+			s = 1113;
+		if (x == 160)
+			s = 1120;
+		if (x == 161)
+			s = 1127;
+		if (x == 162)
+			s = 1134;
+		if (x == 163)
+			s = 1141;
+		if (x == 164)
+			s = 1148;
+		if (x == 165)
+			s = 1155;
+		if (x == 166)
+			s = 1162;
+		if (x == 167)
+			s = 1169;
+		if (x == 168)
+			s = 1176;
+		if (x == 169)
+			s = 1183;
+		if (x == 170)
+			s = 1190;
+		if (x == 171)
+			s = 1197;
+		if (x == 172)
+			s = 1204;
+		if (x == 173)
+			s = 1211;
+		if (x == 174)
+			s = 1218;
+		if (x == 175)
+			s = 1225;
+		if (x == 176)
+			s = 1232;
+		if (x == 177)
+			s = 1239;
+		if (x == 178)
+			s = 1246;
+		if (x == 179)
+			s = 1253;
+		if (x == 180)
+			s = 1260;
+		if (x == 181)
+			s = 1267;
+		if (x == 182)
+			s = 1274;
+		if (x == 183)
+			s = 1281;
+		if (x == 184)
+			s = 1288;
+		if (x == 185)
+			s = 1295;
+		if (x == 186)
+			s = 1302;
+		if (x == 187)
+			s = 1309;
+		if (x == 188)
+			s = 1316;
+		if (x == 189)
+			s = 1323;
+		if (x == 190)
+			s = 1330;
+		if (x == 191)
+			s = 1337;
+		if (x == 192)
+			s = 1344;
+		if (x == 193)
+			s = 1351;
+		if (x == 194)
+			s = 1358;
+		if (x == 195)
+			s = 1365;
+		if (x == 196)
+			s = 1372;
+		if (x == 197)
+			s = 1379;
+		if (x == 198)
+			s = 1386;
+		if (x == 199)
+			s = 1393;
+		if (x == 200)
+			s = 1400;
+	}
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	printf("%d %d\n", far_sum(10), far_sum(250));
+	printf("%d %d %d\n", far_if(3), far_if(6), far_if(200));
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+
+typedef struct {
+	int code;
+	char *name;
+	char tag[4];
+} op_def;
+
+int answer = 42;
+int negative = -7;
+char letter = 'x';
+char *greeting = "hello";
+char buffer[8] = "abc";
+char word[3] = "abc";
+int primes[] = {2, 3, 5, 7, 11};
+int padded[6] = {1, 2};
+char *names[] = {"zero", "one", "two"};
+op_def ops[] = {{1, "add", "+"}, {2, "sub"}, {3}};
+op_def single = {9, "nine", "9"};
+int counter;
+int big[20000] = {1, 2}; /* larger than one initializer buffer used to be */
+char *nothing = NULL;
+
+#ifdef __RISCV
+int read_counter()
+{
+	return counter;
+}
+
+int call_clib()
+{
+	return strlen(greeting);
+}
+
+/* does an instruction among the first bytes of code match pattern under mask, 32-bit ones may start at any halfword */
+int has_instr(char *code, int mask, int pattern)
+{
+	int i, j, word;
+
+	for (i = 0; i < 64; i += 2) {
+		word = 0;
+		for (j = 3; j >= 0; j--)
+			word = (word << 8) + (code[i + j] & 255);
+		if ((word & mask) == pattern)
+			return 1;
+	}
+	return 0;
+}
+#endif
+
+int main()
+{
+	int i;
+	counter++;
+	printf("%d %d %c %s %s %d\n", answer, negative, letter, greeting, buffer, counter);
+	printf("%c%c%c\n", word[0], word[1], word[2]);
+	for (i = 0; i < 5; i++)
+		printf("%d ", primes[i]);
+	for (i = 0; i < 6; i++)
+		printf("%d ", padded[i]);
+	printf("\n%s %s %s\n", names[0], names[1], names[2]);
+	for (i = 0; i < 3; i++)
+		printf("%d %d %s\n", i, ops[i].code, ops[i].tag);
+	printf("%s %s %d %s %s\n", ops[0].name, ops[1].name, single.code, single.name, single.tag);
+	printf("%d\n", nothing == NULL);
+	big[19999] = 3;
+	printf("%d %d %d %d\n", big[0], big[1], big[16384], big[19999]);
+	answer = 43;
+	printf("%d\n", answer);
+#ifdef __RISCV
+	/* globals are read with lw relative to gp, clib is called with jal ra */
+	printf("%d %d\n", has_instr(read_counter, 0xff07f, 0x1a003), has_instr(call_clib, 0xfff, 0xef));
+#endif
+	return 0;
+}
@@ -0,0 +1,71 @@
+typedef struct {
+	int key;
+	int value;
+} pair_t;
+
+int check(int *p, int n, int v)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (p[i] != v)
+			return 0;
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int *a, *b, *c, *big;
+	pair_t *pairs;
+	int i, reused = 0;
+
+	/* freed blocks are handed out again for the same size */
+	a = malloc(40);
+	free(a);
+	b = malloc(36);
+	if (a == b)
+		reused = 1;
+	printf("%d\n", reused);
+
+	/* zeroed even when reusing a dirty block */
+	for (i = 0; i < 9; i++)
+		b[i] = 7;
+	free(b);
+	c = calloc(9, 4);
+	printf("%d\n", check(c, 9, 0));
+
+	/* growth keeps contents */
+	for (i = 0; i < 9; i++)
+		c[i] = i;
+	c = realloc(c, 4000);
+	printf("%d %d %d\n", c[0], c[4], c[8]);
+
+	/* large chunks */
+	big = malloc(100000);
+	for (i = 0; i < 25000; i++)
+		big[i] = 3;
+	printf("%d\n", check(big, 25000, 3));
+	free(big);
+	a = malloc(50000);
+	printf("%d\n", a == big);
+
+	/* many small allocations */
+	pairs = malloc(1000 * sizeof(pair_t));
+	for (i = 0; i < 1000; i++) {
+		pairs[i].key = i;
+		pairs[i].value = i * 2;
+	}
+	b = NULL;
+	for (i = 0; i < 1000; i++) {
+		a = malloc(12);
+		a[0] = pairs[i].value;
+		if (b != NULL)
+			a[1] = (b[0]) + 1;
+		else
+			a[1] = 0;
+		free(b);
+		b = a;
+	}
+	printf("%d %d %d\n", pairs[999].key, b[0], b[1]);
+	return 0;
+}
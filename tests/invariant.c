@@ -0,0 +1,80 @@
+typedef struct {
+	int base;
+	int step;
+} range_t;
+
+int g_limit;
+int g_table[8];
+range_t g_range;
+
+void bump_limit()
+{
+	g_limit++;
+}
+
+int sum_table()
+{
+	int i, s = 0;
+	for (i = 0; i < 8; i++)
+		s += g_table[i] * g_range.step + g_range.base;
+	return s;
+}
+
+int count_to_limit()
+{
+	int i = 0, n = 0;
+	while (i < g_limit) {
+		if (n == 2)
+			bump_limit(); /* changes loop bound */
+		n++;
+		i++;
+	}
+	return n;
+}
+
+int write_through(int *p)
+{
+	int i, s = 0, k = 3;
+	int *q = &k;
+	for (i = 0; i < 4; i++) {
+		s += k;
+		q[0] = i + 10; /* changes k */
+		p[i] = k;
+	}
+	return s;
+}
+
+int nested(range_t *r)
+{
+	int i, j, s = 0;
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 3; j++)
+			s += r->base + (i * r->step) + g_table[j];
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+	int out[4];
+	range_t local;
+
+	for (i = 0; i < 8; i++)
+		g_table[i] = i;
+	g_range.base = 1;
+	g_range.step = 2;
+	printf("%d\n", sum_table());
+
+	g_limit = 4;
+	printf("%d\n", count_to_limit());
+
+	printf("%d", write_through(out));
+	for (i = 0; i < 4; i++)
+		printf(" %d", out[i]);
+	printf("\n");
+
+	local.base = 5;
+	local.step = 10;
+	printf("%d\n", nested(&local));
+	return 0;
+}
@@ -27,6 +27,27 @@ void fcopy_test()
 	fclose(out);
 }
 
+void block_test()
+{
+	char *buffer = malloc(10000);
+	int i, n;
+	FILE *f = fopen("block.txt", "wb");
+
+	for (i = 0; i < 10000; i++)
+		buffer[i] = 'a' + (i & 15);
+	fwrite(buffer, 1, 100, f);
+	fwrite(buffer, 1, 10000, f);
+	fputc('!', f);
+	fclose(f);
+
+	f = fopen("block.txt", "rb");
+	n = fread(buffer, 4, 2500, f);
+	printf("%d %d\n", n, fgetc(f));
+	n = fread(buffer, 10, 100, f);
+	printf("%d %d\n", n, fgetc(f));
+	fclose(f);
+}
+
 void malloc_test()
 {
 	int *array1, *array2, i = 0;
@@ -49,6 +70,7 @@ int main(int argc, char *argv[])
 	}
 
 	fcopy_test();
+	block_test();
 	malloc_test();
 
 	return 0;
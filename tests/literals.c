@@ -0,0 +1,21 @@
+char *pointed = "hello world\n";
+
+char *greeting()
+{
+	return "hello world\n";
+}
+
+int main(int argc, char *argv[])
+{
+	char *a = "hello world\n";
+	char *b = "world\n";
+	char *c = "\n";
+
+	printf("%s%s%s", a, b, greeting());
+	printf("same literal shared: %d\n", a == greeting());
+	printf("suffix shared: %d %d\n", b == a + 6, c == a + 11);
+	printf("%s", "");
+	printf("%d %d\n", strlen(a), strlen(c));
+	printf("initializer shared: %d\n", pointed == a);
+	return 0;
+}
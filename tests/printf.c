@@ -0,0 +1,20 @@
+#include <stdio.h>
+
+int main(int argc, char *argv[])
+{
+	char buf[64];
+	int n;
+
+	printf("%d %d %d %d\n", 0, 7, -42, 2147483647);
+	printf("%d %u %u\n", -2147483648, -1, 3000000000);
+	printf("[%5d] [%05d] [%-d] [%3s] [%c%c] [%%]\n", 42, -42, 5, "ab", 'o', 'k');
+	printf("%x %#x %08x %#010x %p\n", 255, 255, 48879, 48879, 4096);
+	printf("%d %d %d %d %d %d\n", 1, 12, 123, 12345, 123456789, 43699);
+	n = sprintf(buf, "%s-%d", "abc", 99);
+	printf("%s %d\n", buf, n);
+	n = snprintf(buf, 5, "%d", 123456);
+	printf("%s %d\n", buf, n);
+	n = fprintf(stdout, "%s %d\n", "to stdout", 1);
+	printf("%d\n", n);
+	return 0;
+}
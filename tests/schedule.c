@@ -0,0 +1,46 @@
+typedef struct {
+	int x;
+	int y;
+} point_t;
+
+int g_scale;
+point_t g_points[4];
+
+int dot(point_t *a, point_t *b)
+{
+	return (a->x * b->x) + (a->y * b->y);
+}
+
+int swap_sum(int *p, int *q)
+{
+	int a = p[0];
+	int b = q[0];
+	p[0] = b; /* must follow both loads */
+	q[0] = a + 1;
+	return (p[0]) + (q[0]);
+}
+
+int scaled(int i)
+{
+	int a = g_points[i].x * g_scale;
+	g_scale = a; /* later read sees the store */
+	return (g_points[i].y) * g_scale;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, x = 3, y = 4;
+
+	for (i = 0; i < 4; i++) {
+		g_points[i].x = i + 1;
+		g_points[i].y = i * 2;
+	}
+	printf("%d\n", dot(&g_points[1], &g_points[2]));
+	printf("%d\n", swap_sum(&x, &y));
+	printf("%d %d\n", x, y);
+	printf("%d\n", swap_sum(&x, &x));
+	g_scale = 2;
+	printf("%d\n", scaled(3));
+	printf("%d\n", g_scale);
+	return 0;
+}
@@ -0,0 +1,92 @@
+int sign(int v)
+{
+	if (v < 0)
+		return -1;
+	if (v > 0)
+		return 1;
+	return 0;
+}
+
+/* overlapping moves either way at every alignment, against a byte at a time copy, returns how many differ */
+int check_moves(char *a, char *b)
+{
+	int i, j, n, k, bad = 0;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < 8; j++)
+			for (n = 0; n < 40; n += 3) {
+				for (k = 0; k < 64; k++) {
+					a[k] = 'A' + k;
+					b[k] = a[k];
+				}
+				memmove(a + i, a + j, n);
+				if (i < j)
+					for (k = 0; k < n; k++)
+						b[i + k] = b[j + k];
+				else
+					for (k = n - 1; k >= 0; k--)
+						b[i + k] = b[j + k];
+				if (memcmp(a, b, 64) != 0)
+					bad++;
+			}
+	return bad;
+}
+
+int main(int argc, char *argv[])
+{
+	char *a = malloc(300);
+	char *b = malloc(300);
+	int i, j, n, k, c, h = 0;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < 8; j++)
+			for (n = 0; n < 40; n += 3) {
+				memset(a, 'x', 300);
+				memset(b, 'y', 300);
+				memset(a + i, 'a', n);
+				a[i + n] = 0;
+				strcpy(b + j, a + i);
+				h = (h * 3) + strlen(b + j);
+				h = h + sign(strcmp(a + i, b + j));
+				c = b[j + n + 1];
+				h = h + (c == 'y');
+				b[j + (n >> 1)] = 'b';
+				h = (h * 3) + sign(strcmp(a + i, b + j));
+				h = h + sign(strncmp(a + i, b + j, n >> 1));
+				h = h + sign(strncmp(a + i, b + j, n + 5));
+				h = h + sign(memcmp(a + i, b + j, n));
+				memmove(a + i + 1, a + i, n);
+				memmove(b + j, b + j + 2, n);
+				memcpy(a + j + 100, b + i + 3, n + 5);
+				for (k = 0; k < 300; k++) {
+					c = a[k];
+					h = (h * 7) + c;
+					c = b[k];
+					h = h + c;
+				}
+				strncpy(a + 50 + i, b + j, n + 3);
+				for (k = 0; k < 300; k++) {
+					c = a[k];
+					h = (h * 7) + c;
+				}
+				h = h + strlen(a);
+			}
+	printf("%d\n", h);
+
+	strcpy(a, "abcdefghijklmnop");
+	memmove(a + 5, a + 1, 10);
+	printf("%s\n", a);
+	strcpy(a, "abcdefghijklmnop");
+	memmove(a + 1, a + 5, 10);
+	printf("%s\n", a);
+	printf("%d bad moves\n", check_moves(a, b));
+
+	/* bytes compare as unsigned, 200 sorts after 'a' */
+	strcpy(a, "xxxxyz");
+	strcpy(b, "xxxxaz");
+	a[0] = 200;
+	a[4] = 200;
+	printf("%d %d ", sign(strcmp(a, "a")), sign(strcmp(a + 1, b + 1)));
+	printf("%d %d\n", sign(strncmp(a + 4, b + 4, 3)), sign(memcmp(b, a, 6)));
+	return 0;
+}
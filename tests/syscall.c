@@ -0,0 +1,20 @@
+int write_number()
+{
+	return __syscall_write;
+}
+
+int main(int argc, char *argv[])
+{
+	int n = write_number(), len;
+
+	/* number known at compile time, loaded next to the trap */
+	len = __syscall(__syscall_write, 1, "literal\n", 8);
+	printf("%d\n", len);
+	/* numbers computed at run time */
+	len = __syscall(n, 1, "variable\n", 9);
+	printf("%d\n", len);
+	len = __syscall(__syscall_write + argc - argc, 1, "expression\n", 11);
+	printf("%d\n", len);
+	printf("%d\n", __syscall(__syscall_getpid) > 0);
+	return 0;
+}
@@ -0,0 +1,49 @@
+int g_depth;
+
+int count_down(int n, int acc)
+{
+	if (n == 0)
+		return acc;
+	return count_down(n - 1, acc + 1);
+}
+
+int twice(int x)
+{
+	return x * 2;
+}
+
+int forward(int x)
+{
+	return twice(x + 1);
+}
+
+void note(int x)
+{
+	g_depth = x;
+}
+
+void forward_void(int x)
+{
+	note(x);
+}
+
+int read_local(int *p)
+{
+	return p[0];
+}
+
+int local_address(int x)
+{
+	int y = x + 5;
+	return read_local(&y); /* frame must stay */
+}
+
+int main(int argc, char *argv[])
+{
+	printf("%d\n", count_down(200000, 0));
+	printf("%d\n", forward(20));
+	forward_void(7);
+	printf("%d\n", g_depth);
+	printf("%d\n", local_address(37));
+	return 0;
+}